@@ -0,0 +1,44 @@
+#include "Benchmark.h"
+
+#ifndef SIO_BUILD_TYPE
+#define SIO_BUILD_TYPE "inconnu"
+#endif
+
+#ifndef SIO_COMPILER
+#define SIO_COMPILER "inconnu"
+#endif
+
+const char CSV_SEPARATOR = ';';
+
+void BenchmarkReport::add(const std::string& suite, const std::string& name, uint64_t param, double value,
+                          const std::string& unit) {
+    results.push_back({suite, name, param, value, unit});
+    std::cerr << suite << " / " << name << " / " << param << ": " << value << " " << unit << std::endl;
+}
+
+void BenchmarkReport::writeCsv(std::ostream& os) const {
+    os << "suite" << CSV_SEPARATOR << "nom" << CSV_SEPARATOR << "parametre" << CSV_SEPARATOR << "valeur"
+       << CSV_SEPARATOR << "unite" << std::endl;
+
+    for (const BenchmarkResult& r : results) {
+        os << r.suite << CSV_SEPARATOR << r.name << CSV_SEPARATOR << r.param << CSV_SEPARATOR << r.value
+           << CSV_SEPARATOR << r.unit << std::endl;
+    }
+}
+
+void BenchmarkReport::writeJson(std::ostream& os) const {
+    os << "{\n";
+    os << "  \"build_type\": \"" << SIO_BUILD_TYPE << "\",\n";
+    os << "  \"compiler\": \"" << SIO_COMPILER << "\",\n";
+    os << "  \"results\": [\n";
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& r = results[i];
+        os << "    {\"suite\": \"" << r.suite << "\", \"name\": \"" << r.name << "\", \"param\": " << r.param
+           << ", \"value\": " << r.value << ", \"unit\": \"" << r.unit << "\"}";
+        os << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+
+    os << "  ]\n";
+    os << "}" << std::endl;
+}
@@ -0,0 +1,77 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * Options communes a tous les benchmarks (voir main.cpp).
+ */
+struct BenchmarkOptions {
+    bool quick = false;          // tailles reduites (verification rapide)
+    uint64_t maxPieces = 10000000; // nombre maximal de morceaux des fonctions affines par morceaux
+    std::string filter;          // n'execute que les suites dont le nom contient ce filtre
+};
+
+/**
+ * Resultat d'une mesure.
+ */
+struct BenchmarkResult {
+    std::string suite;      // famille de benchmarks (ex: "generateur")
+    std::string name;       // element mesure (ex: "InverseFunctions")
+    uint64_t param;         // parametre de la mesure (ex: nombre de morceaux)
+    double value;           // valeur mesuree
+    std::string unit;       // unite de la valeur (ex: "ns/echantillon")
+};
+
+/**
+ * Collecte les resultats des benchmarks et les ecrit dans un format lisible par une machine (CSV ou JSON), afin de
+ * pouvoir suivre les regressions entre les versions.
+ */
+class BenchmarkReport {
+private:
+    std::vector<BenchmarkResult> results;
+
+public:
+    /**
+     * Ajoute un resultat (et l'affiche sur la sortie d'erreur pour suivre la progression).
+     */
+    void add(const std::string& suite, const std::string& name, uint64_t param, double value, const std::string& unit);
+
+    /**
+     * Ecrit les resultats en CSV (separateur ';', une ligne d'en-tete).
+     */
+    void writeCsv(std::ostream& os) const;
+
+    /**
+     * Ecrit les resultats en JSON, avec la description de la compilation.
+     */
+    void writeJson(std::ostream& os) const;
+};
+
+typedef std::chrono::steady_clock BenchmarkClock;
+
+/**
+ * @return Le temps ecoule (en nanosecondes) depuis un instant donne.
+ */
+inline double nanosecondsSince(BenchmarkClock::time_point beg) {
+    return std::chrono::duration<double, std::nano>(BenchmarkClock::now() - beg).count();
+}
+
+/**
+ * Empeche le compilateur de supprimer un calcul dont le resultat n'est pas utilise.
+ */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// suites de benchmarks
+void runGeneratorBenchmarks(const BenchmarkOptions& options, BenchmarkReport& report);
+void runPiecewiseLinearBenchmarks(const BenchmarkOptions& options, BenchmarkReport& report);
+void runEstimatorBenchmarks(const BenchmarkOptions& options, BenchmarkReport& report);
+
+#endif // BENCHMARK_H
@@ -0,0 +1,68 @@
+#ifndef BENCHMARK_FUNCTIONS_H
+#define BENCHMARK_FUNCTIONS_H
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+
+#include "Benchmark.h"
+#include "generators/RandomEngine.h"
+#include "utility/Stats.h"
+#include "utility/FastMath.h"
+
+/**
+ * Fonction dont on estime l'aire dans main.cpp.
+ */
+struct MainIntegrand {
+    double operator()(double x) const {
+        return (25 + x * (x - 6) * (x - 8) * (x - 14) / 25) * exp(sqrt(1 + cos(x*x / 10)));
+    }
+};
+
+/**
+ * Meme fonction, sous forme d'expression (voir Expression).
+ */
+const char* const MAIN_EXPRESSION = "(25 + x*(x-6)*(x-8)*(x-14)/25) * exp(sqrt(1 + cos(x^2/10)))";
+
+/**
+ * Meme fonction, evaluee par lots avec les approximations vectorisees de FastMath.
+ */
+struct MainBatchIntegrand {
+    void operator()(const double* xs, double* ys, size_t n) const {
+        for (size_t i = 0; i < n; ++i) {
+            double x = xs[i];
+            ys[i] = (25 + x * (x - 6) * (x - 8) * (x - 14) / 25)
+                    * FastMath::exp(FastMath::sqrt(1 + FastMath::cos(x*x / 10)));
+        }
+    }
+};
+
+/**
+ * @return Les nombres de morceaux a mesurer: 15, puis les puissances de 10 jusqu'a options.maxPieces.
+ */
+inline std::vector<uint64_t> pieceCounts(const BenchmarkOptions& options) {
+    std::vector<uint64_t> counts;
+    if (options.maxPieces >= 15) {
+        counts.push_back(15);
+    }
+    for (uint64_t K = 100; K <= options.maxPieces; K *= 10) {
+        counts.push_back(K);
+    }
+    return counts;
+}
+
+/**
+ * Cree une fonction affine par morceaux irreguliere de K morceaux sur [0, 1].
+ */
+inline Points randomPoints(uint64_t K, RandomEngine& engine) {
+    Points points;
+    points.xs.resize(K + 1);
+    points.ys.resize(K + 1);
+    for (uint64_t i = 0; i <= K; ++i) {
+        points.xs[i] = (double)i / K;
+        points.ys[i] = 0.1 + uniform01(engine) * uniform01(engine) * 10;
+    }
+    return points;
+}
+
+#endif // BENCHMARK_FUNCTIONS_H
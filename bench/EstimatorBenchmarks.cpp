@@ -0,0 +1,139 @@
+#include <thread>
+#include <string>
+#include <utility>
+
+#include "Benchmark.h"
+#include "BenchmarkFunctions.h"
+#include "montecarlo/UniformSampling.h"
+#include "montecarlo/ImportanceSampling.h"
+#include "montecarlo/ControlVariableMethod.h"
+#include "montecarlo/StratifiedSampling.h"
+#include "utility/Expression.h"
+
+/**
+ * Mesure le debit d'une methode (echantillons par seconde) sur un echantillon de taille N.
+ */
+static void measure(BenchmarkReport& report, const std::string& name, MonteCarloMethod& m, uint64_t N) {
+    std::seed_seq seed = {24, 512, 42};
+    m.setSeed(seed);
+
+    MonteCarloMethod::Sampling s = m.sampleWithSize(N);
+    doNotOptimize(s.areaEstimator);
+    report.add("methodes", name, N, s.N / s.elapsedTime, "echantillons/s");
+}
+
+/**
+ * Mesure une methode dans ses differents modes: fonction Func, connue a la compilation, evaluee par lots (FastMath)
+ * ou compilee a l'execution (Expression), sequentiel ou parallele.
+ */
+template <typename Method, typename... Args>
+static void measureModes(BenchmarkReport& report, const std::string& name, uint64_t N, unsigned numThreads,
+                         Args... args) {
+    MonteCarloMethod::Func func = MainIntegrand();
+    {
+        Method m(func, args...);
+        measure(report, name + "/Func", m, N);
+    }
+    {
+        Method m(MainIntegrand(), args...);
+        measure(report, name + "/inline", m, N);
+
+        m.setNumThreads(numThreads);
+        measure(report, name + "/inline/" + std::to_string(numThreads) + " threads", m, N);
+    }
+    {
+        Method m(MainBatchIntegrand(), args...);
+        measure(report, name + "/lots", m, N);
+    }
+    {
+        Method m(Expression(MAIN_EXPRESSION), args...);
+        measure(report, name + "/expression", m, N);
+    }
+}
+
+void runEstimatorBenchmarks(const BenchmarkOptions& options, BenchmarkReport& report) {
+    const uint64_t N = options.quick ? 1000000 : 10000000;
+    unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    double a = 0, b = 15;
+    Points points = Stats::createPoints(15, MainIntegrand(), a, b);
+
+    measureModes<UniformSampling>(report, "UniformSampling", N, numThreads, a, b);
+    // le generateur d'ImportanceSampling est toujours InverseFunctions (appel statique par lot): il figure dans le nom
+    measureModes<ImportanceSampling>(report, "ImportanceSampling/InverseFunctions", N, numThreads,
+                                     points.xs, points.ys);
+    measureModes<StratifiedSampling>(report, "StratifiedSampling", N, numThreads, points.xs);
+
+    {
+        ControlVariable m(MainIntegrand(), a, b, points.xs, points.ys);
+        m.setSamplingSize(10000);
+        measure(report, "ControlVariable/inline", m, N);
+
+        m.setNumThreads(numThreads);
+        measure(report, "ControlVariable/inline/" + std::to_string(numThreads) + " threads", m, N);
+    }
+
+    // debit de la phase pilote (co-moments de (Y, Z) par lots) a comparer a celui de la phase principale ci-dessus:
+    // tout l'echantillon est pilote, ou les coefficients sont recalcules a chaque etape
+    {
+        ControlVariable m(MainIntegrand(), a, b, points.xs, points.ys);
+        m.setSamplingSize(N);
+        measure(report, "ControlVariable/inline/pilote", m, N);
+
+        m.setNumThreads(numThreads);
+        measure(report, "ControlVariable/inline/pilote/" + std::to_string(numThreads) + " threads", m, N);
+    }
+    {
+        ControlVariable m(MainIntegrand(), a, b, points.xs, points.ys);
+        m.setSamplingSize(0);
+        m.setRunningConstant(true);
+        measure(report, "ControlVariable/inline/coefficients continus", m, N);
+    }
+
+    // variables antithetiques
+    {
+        UniformSampling m(MainIntegrand(), a, b);
+        m.setAntithetic(true);
+        measure(report, "UniformSampling/inline/antithetique", m, N);
+    }
+    {
+        ControlVariable m(MainIntegrand(), a, b, points.xs, points.ys);
+        m.setSamplingSize(10000);
+        m.setAntithetic(true);
+        measure(report, "ControlVariable/inline/antithetique", m, N);
+    }
+
+    // echantillonnage preferentiel adaptatif
+    {
+        ImportanceSampling m(MainIntegrand(), points.xs, points.ys);
+        m.setAdaptive(100000);
+        measure(report, "ImportanceSampling/InverseFunctions/inline/adaptatif", m, N);
+    }
+
+    // quasi-Monte Carlo randomise
+    {
+        UniformSampling m(MainIntegrand(), a, b);
+        m.setQuasiRandom(16);
+        measure(report, "UniformSampling/inline/RQMC", m, N);
+    }
+    {
+        ImportanceSampling m(MainIntegrand(), points.xs, points.ys);
+        m.setQuasiRandom(16);
+        measure(report, "ImportanceSampling/InverseFunctions/inline/RQMC", m, N);
+    }
+
+    // moteurs aleatoires
+    const std::pair<RandomEngine::Kind, std::string> engines[] = {
+            {RandomEngine::Kind::XOSHIRO256PP, "xoshiro256++"},
+            {RandomEngine::Kind::PCG64, "pcg64"},
+            {RandomEngine::Kind::PHILOX4X64, "philox4x64"}};
+    for (const auto& engine : engines) {
+        UniformSampling uniform(MainIntegrand(), a, b);
+        uniform.setEngine(engine.first);
+        measure(report, "UniformSampling/inline/" + engine.second, uniform, N);
+
+        ImportanceSampling importance(MainIntegrand(), points.xs, points.ys);
+        importance.setEngine(engine.first);
+        measure(report, "ImportanceSampling/InverseFunctions/inline/" + engine.second, importance, N);
+    }
+}
@@ -0,0 +1,135 @@
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "Benchmark.h"
+#include "BenchmarkFunctions.h"
+#include "generators/PieceSelector.h"
+#include "generators/RandomValueGenerator.h"
+
+/**
+ * Recherche lineaire telle qu'effectuee avant l'introduction de PieceSelector (reference).
+ */
+static uint64_t linearScan(const std::vector<double>& F_parts, double U) {
+    uint64_t j = 1;
+    while (j < F_parts.size() - 1 && U > F_parts[j]) {
+        ++j;
+    }
+    return j - 1;
+}
+
+/**
+ * Mesure le cout d'une selection de tranche pour chaque valeur de us.
+ */
+template <typename Select>
+static double nsPerSelection(const std::vector<double>& us, size_t numDraws, Select select) {
+    uint64_t check = 0;
+    BenchmarkClock::time_point beg = BenchmarkClock::now();
+    for (size_t i = 0; i < numDraws; ++i) {
+        check += select(us[i]);
+    }
+    doNotOptimize(check);
+    return nanosecondsSince(beg) / numDraws;
+}
+
+/**
+ * Mesure le cout par realisation de generateBatch.
+ */
+static double nsPerSample(RandomValueGenerator& generator, std::vector<double>& out) {
+    BenchmarkClock::time_point beg = BenchmarkClock::now();
+    generator.generateBatch(out.data(), out.size());
+    doNotOptimize(out.back());
+    return nanosecondsSince(beg) / out.size();
+}
+
+/**
+ * Mesure le cout par realisation U(0,1) du remplissage par lots d'un moteur.
+ */
+static double nsPerUniform(RandomEngine::Kind kind, std::vector<double>& out) {
+    RandomEngine engine(kind);
+    BenchmarkClock::time_point beg = BenchmarkClock::now();
+    fillUniform(engine, out.data(), out.size());
+    doNotOptimize(out.back());
+    return nanosecondsSince(beg) / out.size();
+}
+
+static std::string methodName(PieceSelector::Method method) {
+    return method == PieceSelector::Method::ALIAS ? "alias" : "guide";
+}
+
+void runGeneratorBenchmarks(const BenchmarkOptions& options, BenchmarkReport& report) {
+    const size_t numDraws = options.quick ? 200000 : 2000000;
+
+    RandomEngine engine(42);
+    std::vector<double> us(numDraws), out(numDraws);
+    fillUniform(engine, us.data(), us.size());
+
+    // moteurs aleatoires
+    report.add("moteur", "mt19937_64", 1, nsPerUniform(RandomEngine::Kind::MT19937_64, out), "ns/realisation");
+    report.add("moteur", "xoshiro256++", 1, nsPerUniform(RandomEngine::Kind::XOSHIRO256PP, out), "ns/realisation");
+    report.add("moteur", "pcg64", 1, nsPerUniform(RandomEngine::Kind::PCG64, out), "ns/realisation");
+    report.add("moteur", "philox4x64", 1, nsPerUniform(RandomEngine::Kind::PHILOX4X64, out), "ns/realisation");
+
+    for (uint64_t K : pieceCounts(options)) {
+        Points points = randomPoints(K, engine);
+
+        // selection de la tranche
+        PiecewiseLinearFunction f(points.xs, points.ys);
+        std::vector<double> pks, F_parts(1, 0);
+        for (uint64_t k = 0; k < f.size(); ++k) {
+            pks.push_back(f.area(k) / f.A);
+            F_parts.push_back(F_parts.back() + pks.back());
+        }
+
+        {
+            PieceSelector guide(pks, PieceSelector::Method::GUIDE);
+            report.add("selection", "guide", K,
+                       nsPerSelection(us, numDraws, [&](double U) { return guide.select(U); }), "ns/tirage");
+        }
+        {
+            PieceSelector alias(pks, PieceSelector::Method::ALIAS);
+            report.add("selection", "alias", K,
+                       nsPerSelection(us, numDraws, [&](double U) { return alias.select(U); }), "ns/tirage");
+        }
+
+        // la recherche lineaire est en O(K): on limite le nombre de tirages
+        if (K <= 100000) {
+            size_t numScans = K <= 1000 ? numDraws : numDraws / (K / 1000);
+            report.add("selection", "lineaire", K,
+                       nsPerSelection(us, numScans, [&](double U) { return linearScan(F_parts, U); }), "ns/tirage");
+        }
+
+        // generateurs complets (methode de selection choisie automatiquement)
+        {
+            HitOrMiss generator(points.xs, points.ys);
+            report.add("generateur", "HitOrMiss", K, nsPerSample(generator, out), "ns/echantillon");
+
+            double yMax = *std::max_element(points.ys.begin(), points.ys.end());
+            report.add("acceptation", "HitOrMiss", K, f.A / ((points.xs.back() - points.xs.front()) * yMax), "taux");
+        }
+        // la table de selection des cellules a DEFAULT_SUBDIVISIONS fois plus d'entrees que les autres
+        if (K <= 1000000) {
+            EnvelopeRejection generator(points.xs, points.ys);
+            report.add("generateur", "EnvelopeRejection/" + methodName(generator.getSelectionMethod()), K,
+                       nsPerSample(generator, out), "ns/echantillon");
+            report.add("acceptation", "EnvelopeRejection", K, generator.getAcceptanceRate(), "taux");
+            report.add("acceptation", "EnvelopeRejection/squeeze", K, generator.getSqueezeRate(), "taux");
+        }
+        {
+            Geometric generator(points.xs, points.ys);
+            report.add("generateur", "Geometric/" + methodName(generator.getSelectionMethod()), K,
+                       nsPerSample(generator, out), "ns/echantillon");
+        }
+        {
+            InverseFunctions generator(points.xs, points.ys);
+            report.add("generateur", "InverseFunctions/" + methodName(generator.getSelectionMethod()), K,
+                       nsPerSample(generator, out), "ns/echantillon");
+        }
+        // mode table: 4 cellules par morceau, soit 88 octets par morceau avec l'inversion des morceaux
+        if (K <= 1000000) {
+            InverseFunctions generator(points.xs, points.ys);
+            generator.setTableResolution(4 * K);
+            report.add("generateur", "InverseFunctions/table", K, nsPerSample(generator, out), "ns/echantillon");
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#include <vector>
+
+#include "Benchmark.h"
+#include "BenchmarkFunctions.h"
+#include "utility/PiecewiseLinearFunction.h"
+
+void runPiecewiseLinearBenchmarks(const BenchmarkOptions& options, BenchmarkReport& report) {
+    const size_t numCalls = options.quick ? 200000 : 2000000;
+
+    RandomEngine engine(42);
+    std::vector<double> xs(numCalls), ys(numCalls);
+    fillUniform(engine, xs.data(), xs.size());
+
+    for (uint64_t K : pieceCounts(options)) {
+        Points points = randomPoints(K, engine);
+        PiecewiseLinearFunction f(points.xs, points.ys);
+
+        {
+            uint64_t check = 0;
+            BenchmarkClock::time_point beg = BenchmarkClock::now();
+            for (double x : xs) {
+                check += f.findPiece(x);
+            }
+            doNotOptimize(check);
+            report.add("pwl", "findPiece", K, nanosecondsSince(beg) / numCalls, "ns/appel");
+        }
+        {
+            double check = 0;
+            BenchmarkClock::time_point beg = BenchmarkClock::now();
+            for (double x : xs) {
+                check += f(x);
+            }
+            doNotOptimize(check);
+            report.add("pwl", "operator()", K, nanosecondsSince(beg) / numCalls, "ns/appel");
+        }
+        {
+            BenchmarkClock::time_point beg = BenchmarkClock::now();
+            f.evaluate(xs.data(), ys.data(), numCalls);
+            doNotOptimize(ys.back());
+            report.add("pwl", "evaluate", K, nanosecondsSince(beg) / numCalls, "ns/appel");
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "Benchmark.h"
+
+using namespace std;
+
+/**
+ * Lance les benchmarks et ecrit les resultats sur la sortie standard.
+ *
+ * Options:
+ *   --json           resultats en JSON (CSV par defaut)
+ *   --quick          tailles reduites
+ *   --max-pieces=N   nombre maximal de morceaux des fonctions affines par morceaux (10^7 par defaut)
+ *   --filter=NOM     n'execute que les suites dont le nom contient NOM (generateurs, pwl, methodes)
+ */
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    bool json = false;
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+
+        if (arg == "--json") {
+            json = true;
+        } else if (arg == "--quick") {
+            options.quick = true;
+        } else if (arg.compare(0, 13, "--max-pieces=") == 0) {
+            options.maxPieces = strtoull(arg.c_str() + 13, nullptr, 10);
+        } else if (arg.compare(0, 9, "--filter=") == 0) {
+            options.filter = arg.substr(9);
+        } else {
+            cerr << "Option inconnue: " << arg << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (options.quick && options.maxPieces > 100000) {
+        options.maxPieces = 100000;
+    }
+
+    BenchmarkReport report;
+
+    if (string("generateurs").find(options.filter) != string::npos) {
+        runGeneratorBenchmarks(options, report);
+    }
+    if (string("pwl").find(options.filter) != string::npos) {
+        runPiecewiseLinearBenchmarks(options, report);
+    }
+    if (string("methodes").find(options.filter) != string::npos) {
+        runEstimatorBenchmarks(options, report);
+    }
+
+    if (json) {
+        report.writeJson(cout);
+    } else {
+        report.writeCsv(cout);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "WorkerChannel.h"
+
+// taille maximale du contenu d'un message (un etat d'echantillonnage fait quelques Ko)
+static const uint64_t MAX_MESSAGE_SIZE = uint64_t(1) << 30;
+
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL; // une connexion fermee leve une exception plutot que SIGPIPE
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+/**
+ * Envoie tous les octets d'un tampon.
+ *
+ * @throw std::runtime_error Si la connexion est fermee.
+ */
+static void sendAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = ::send(fd, data, size, SEND_FLAGS);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Connexion au processus de calcul interrompue.");
+        }
+        data += sent;
+        size -= (size_t)sent;
+    }
+}
+
+/**
+ * Recoit exactement size octets.
+ *
+ * @throw std::runtime_error Si la connexion est fermee avant.
+ */
+static void receiveAll(int fd, char* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = ::recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            throw std::runtime_error("Connexion au processus de calcul fermee.");
+        }
+        data += received;
+        size -= (size_t)received;
+    }
+}
+
+/**
+ * @return L'adresse d'une socket Unix.
+ * @throw std::invalid_argument Si le chemin est trop long.
+ */
+static sockaddr_un socketAddress(const std::string& path) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (path.empty() || path.size() >= sizeof(addr.sun_path)) {
+        throw std::invalid_argument("Chemin de socket vide ou trop long: " + path);
+    }
+    path.copy(addr.sun_path, path.size());
+    return addr;
+}
+
+WorkerChannel::WorkerChannel(int fd, long pid) : fd(fd), pid(pid) {}
+
+WorkerChannel::~WorkerChannel() {
+    // le processus fils se termine a la fermeture de la connexion
+    close(fd);
+    if (pid > 0) {
+        while (waitpid((pid_t)pid, nullptr, 0) < 0 && errno == EINTR) {
+        }
+    }
+}
+
+std::unique_ptr<WorkerChannel> WorkerChannel::spawn(const Session& session) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        throw std::runtime_error("Impossible de creer la connexion au processus de calcul.");
+    }
+
+    pid_t child = fork();
+    if (child < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        throw std::runtime_error("Impossible de creer le processus de calcul.");
+    }
+
+    if (child == 0) {
+        close(fds[0]);
+        int status = EXIT_SUCCESS;
+        try {
+            WorkerChannel channel(fds[1], 0);
+            session(channel);
+        } catch (...) {
+            status = EXIT_FAILURE;
+        }
+        _exit(status);
+    }
+
+    close(fds[1]);
+    return std::unique_ptr<WorkerChannel>(new WorkerChannel(fds[0], (long)child));
+}
+
+std::unique_ptr<WorkerChannel> WorkerChannel::connect(const std::string& path) {
+    sockaddr_un addr = socketAddress(path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw std::runtime_error("Impossible de creer une socket.");
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        throw std::runtime_error("Impossible de se connecter au processus de calcul: " + path);
+    }
+    return std::unique_ptr<WorkerChannel>(new WorkerChannel(fd, 0));
+}
+
+void WorkerChannel::listen(const std::string& path, const Session& session) {
+    sockaddr_un addr = socketAddress(path);
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0) {
+        throw std::runtime_error("Impossible de creer une socket.");
+    }
+
+    unlink(path.c_str());
+    if (bind(server, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(server, 16) != 0) {
+        close(server);
+        throw std::runtime_error("Impossible d'attendre des connexions sur " + path);
+    }
+
+    while (true) {
+        int fd = accept(server, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            close(server);
+            throw std::runtime_error("Impossible d'accepter une connexion sur " + path);
+        }
+
+        // une connexion interrompue n'arrete que sa session
+        WorkerChannel channel(fd, 0);
+        try {
+            session(channel);
+        } catch (const std::runtime_error&) {
+        }
+    }
+}
+
+void WorkerChannel::send(char type, const std::string& content) {
+    char header[1 + sizeof(uint64_t)];
+    uint64_t size = content.size();
+    header[0] = type;
+    std::memcpy(header + 1, &size, sizeof(size));
+
+    sendAll(fd, header, sizeof(header));
+    sendAll(fd, content.data(), content.size());
+}
+
+char WorkerChannel::receive(std::string& content) {
+    char header[1 + sizeof(uint64_t)];
+    uint64_t size;
+    receiveAll(fd, header, sizeof(header));
+    std::memcpy(&size, header + 1, sizeof(size));
+
+    if (size > MAX_MESSAGE_SIZE) {
+        throw std::runtime_error("Message du processus de calcul invalide.");
+    }
+
+    content.resize(size);
+    if (size > 0) {
+        receiveAll(fd, &content[0], size);
+    }
+    return header[0];
+}
@@ -0,0 +1,90 @@
+#ifndef WORKER_CHANNEL_H
+#define WORKER_CHANNEL_H
+
+#include <string>
+#include <memory>
+#include <functional>
+
+/**
+ * Connexion entre le processus coordinateur et un processus de calcul du mode reparti (voir
+ * MonteCarloMethod::setNumProcesses et MonteCarloMethod::setRemoteWorkers): socket de type flux sur laquelle sont
+ * echanges des messages (type sur 1 octet, longueur du contenu sur 8 octets, contenu).
+ *
+ * Le processus de calcul est soit un processus fils cree par fork (qui dispose alors d'une copie de la memoire du
+ * coordinateur), soit un processus independant attendant des connexions sur une socket Unix (voir listen). Les deux
+ * utilisent les memes messages: un processus local peut donc remplacer un noeud distant (ex: pour les tests).
+ *
+ * Disponible uniquement sur les systemes POSIX.
+ */
+class WorkerChannel {
+public:
+    // traitement des messages d'une connexion, du cote du processus de calcul
+    typedef std::function<void(WorkerChannel&)> Session;
+
+private:
+    int fd;    // descripteur de la socket
+    long pid;  // processus fils a attendre a la fermeture (0 si la connexion n'a pas cree le processus)
+
+    WorkerChannel(int fd, long pid);
+
+public:
+    /**
+     * Ferme la connexion et attend la fin du processus fils, s'il y en a un.
+     */
+    ~WorkerChannel();
+
+    WorkerChannel(const WorkerChannel&) = delete;
+    WorkerChannel& operator=(const WorkerChannel&) = delete;
+
+    /**
+     * Cree un processus fils relie au processus appelant par une paire de sockets. Le fils execute la session puis se
+     * termine (sans executer les destructeurs des objets globaux du coordinateur), avec un code d'erreur si elle a
+     * leve une exception.
+     *
+     * @param session Le traitement des messages, execute dans le processus fils.
+     * @return La connexion au processus fils.
+     * @throw std::runtime_error Si le processus ne peut pas etre cree.
+     */
+    static std::unique_ptr<WorkerChannel> spawn(const Session& session);
+
+    /**
+     * Se connecte a un processus de calcul attendant des connexions (voir listen).
+     *
+     * @param path Le chemin de la socket Unix du processus.
+     * @return La connexion.
+     * @throw std::runtime_error Si la connexion echoue.
+     */
+    static std::unique_ptr<WorkerChannel> connect(const std::string& path);
+
+    /**
+     * Attend des connexions sur une socket Unix et execute une session par connexion, l'une apres l'autre. Une
+     * connexion interrompue (ex: arret du coordinateur) termine sa session sans arreter l'attente. Ne retourne pas:
+     * le processus est arrete par un signal.
+     *
+     * @param path Le chemin de la socket (remplace le fichier existant, s'il y en a un).
+     * @param session Le traitement des messages de chaque connexion.
+     * @throw std::invalid_argument Si le chemin est trop long pour une socket Unix.
+     * @throw std::runtime_error Si la socket ne peut pas etre creee.
+     */
+    static void listen(const std::string& path, const Session& session);
+
+    /**
+     * Envoie un message.
+     *
+     * @param type Le type du message.
+     * @param content Le contenu du message.
+     * @throw std::runtime_error Si la connexion est fermee.
+     */
+    void send(char type, const std::string& content);
+
+    /**
+     * Attend le message suivant.
+     *
+     * @param content Le contenu du message recu.
+     * @return Le type du message.
+     * @throw std::runtime_error Si la connexion est fermee.
+     */
+    char receive(std::string& content);
+};
+
+#endif // WORKER_CHANNEL_H
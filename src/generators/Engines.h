@@ -0,0 +1,410 @@
+#ifndef ENGINES_H
+#define ENGINES_H
+
+#include <random>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Generateurs de nombres pseudo-aleatoires rapides pouvant remplacer std::mt19937_64 (voir RandomEngine).
+ *
+ * Chacun respecte l'interface d'un generateur de la bibliotheque standard (result_type, min, max, operator(),
+ * seed(std::seed_seq&)) et fournit un remplissage par lots de realisations U(0,1), dans le meme ordre que des appels
+ * successifs a operator() suivis de toUnit. Les lots sont generes sur plusieurs voies independantes, que le
+ * compilateur peut vectoriser (ou au moins executer en parallele dans le processeur).
+ */
+
+/**
+ * Convertit 64 bits aleatoires en un double de [0,1): les 52 bits de poids fort forment la mantisse d'un double de
+ * [1,2), auquel on retire 1 (copie de bits, sans conversion entier-flottant).
+ *
+ * @param x Les bits aleatoires.
+ * @return Le double de [0,1) correspondant.
+ */
+inline double toUnit(uint64_t x) {
+    uint64_t bits = 0x3FF0000000000000ULL | (x >> 12);
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d - 1.0;
+}
+
+/**
+ * xoshiro256++ (Blackman et Vigna) sur LANES voies entrelacees: la i-eme valeur est produite par la voie i % LANES.
+ * Chaque voie a son propre etat de 256 bits (initialise par la graine); les voies avancent ensemble, ce qui permet
+ * de vectoriser le remplissage par lots.
+ */
+class Xoshiro256PlusPlus {
+public:
+    typedef uint64_t result_type;
+
+    static const size_t LANES = 4;
+
+private:
+    uint64_t s[4][LANES];        // etat de chaque voie (mot j de la voie l: s[j][l])
+    uint64_t buffered[LANES];    // dernieres valeurs produites par les voies
+    size_t next = LANES;         // indice de la prochaine valeur a rendre dans buffered
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    /**
+     * Fait avancer toutes les voies d'un pas.
+     *
+     * @param out Le tampon dans lequel ecrire les LANES valeurs produites.
+     */
+    void step(uint64_t* out) {
+        for (size_t l = 0; l < LANES; ++l) {
+            out[l] = rotl(s[0][l] + s[3][l], 23) + s[0][l];
+
+            uint64_t t = s[1][l] << 17;
+            s[2][l] ^= s[0][l];
+            s[3][l] ^= s[1][l];
+            s[1][l] ^= s[2][l];
+            s[0][l] ^= s[3][l];
+            s[2][l] ^= t;
+            s[3][l] = rotl(s[3][l], 45);
+        }
+    }
+
+public:
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return ~(result_type)0;
+    }
+
+    Xoshiro256PlusPlus() {
+        std::seed_seq seq;
+        seed(seq);
+    }
+
+    void seed(std::seed_seq& seq) {
+        uint32_t words[8 * LANES];
+        seq.generate(words, words + 8 * LANES);
+
+        for (size_t l = 0; l < LANES; ++l) {
+            bool zero = true;
+            for (size_t j = 0; j < 4; ++j) {
+                s[j][l] = (uint64_t)words[8*l + 2*j] << 32 | words[8*l + 2*j + 1];
+                zero = zero && s[j][l] == 0;
+            }
+            if (zero) {
+                s[0][l] = 1; // l'etat nul est le seul etat interdit
+            }
+        }
+        next = LANES;
+    }
+
+    /**
+     * Fixe l'etat d'une voie (ex: vecteurs de test de l'implementation de reference). Les valeurs deja produites et
+     * pas encore rendues sont abandonnees.
+     *
+     * @param lane L'indice de la voie.
+     * @param state Les 4 mots de l'etat (non tous nuls).
+     */
+    void setLaneState(size_t lane, const uint64_t state[4]) {
+        for (size_t j = 0; j < 4; ++j) {
+            s[j][lane] = state[j];
+        }
+        next = LANES;
+    }
+
+    result_type operator()() {
+        if (next == LANES) {
+            step(buffered);
+            next = 0;
+        }
+        return buffered[next++];
+    }
+
+    /**
+     * Remplit un tampon de realisations U(0,1) (voir toUnit).
+     */
+    void fill(double* out, size_t n) {
+        size_t i = 0;
+        while (i < n && next < LANES) {
+            out[i++] = toUnit(buffered[next++]);
+        }
+
+        uint64_t values[LANES];
+        for (; i + LANES <= n; i += LANES) {
+            step(values);
+            for (size_t l = 0; l < LANES; ++l) {
+                out[i + l] = toUnit(values[l]);
+            }
+        }
+
+        while (i < n) {
+            out[i++] = toUnit((*this)());
+        }
+    }
+};
+
+/**
+ * PCG64 (O'Neill): generateur congruentiel lineaire de 128 bits (increment impair choisi par la graine) suivi de la
+ * permutation XSL RR. Une valeur est produite a partir de l'etat apres chaque pas.
+ *
+ * Le remplissage par lots fait avancer LANES etats consecutifs de LANES pas a la fois (a^LANES, c(1 + a + ... +
+ * a^(LANES-1))): les multiplications de 128 bits des voies sont independantes.
+ */
+class Pcg64 {
+public:
+    typedef uint64_t result_type;
+
+    static const size_t LANES = 4;
+
+private:
+    // entier de 128 bits de GCC et Clang (__extension__: pas d'avertissement en mode -Wpedantic)
+    __extension__ typedef unsigned __int128 uint128;
+
+    uint128 state, inc;
+
+    static uint128 multiplier() {
+        return (uint128)0x2360ED051FC65DA4ULL << 64 | 0x4385DF649FCCF645ULL;
+    }
+
+    static uint64_t output(uint128 s) {
+        uint64_t x = (uint64_t)(s >> 64) ^ (uint64_t)s;
+        unsigned rot = (unsigned)(s >> 122);
+        return (x >> rot) | (x << ((64 - rot) & 63));
+    }
+
+public:
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return ~(result_type)0;
+    }
+
+    Pcg64() {
+        std::seed_seq seq;
+        seed(seq);
+    }
+
+    void seed(std::seed_seq& seq) {
+        uint32_t words[8];
+        seq.generate(words, words + 8);
+
+        uint128 initState = 0, initSeq = 0;
+        for (size_t j = 0; j < 4; ++j) {
+            initState = initState << 32 | words[j];
+            initSeq = initSeq << 32 | words[4 + j];
+        }
+        seed(initState, initSeq);
+    }
+
+    /**
+     * Initialisation de reference (pcg_setseq_128_srandom_r).
+     *
+     * @param initState L'etat initial.
+     * @param initSeq Le choix de la suite (increment).
+     */
+    void seed(uint128 initState, uint128 initSeq) {
+        state = 0;
+        inc = initSeq << 1 | 1;
+        state = state * multiplier() + inc;
+        state += initState;
+        state = state * multiplier() + inc;
+    }
+
+    result_type operator()() {
+        state = state * multiplier() + inc;
+        return output(state);
+    }
+
+    /**
+     * Remplit un tampon de realisations U(0,1) (voir toUnit).
+     */
+    void fill(double* out, size_t n) {
+        size_t i = 0;
+
+        if (n >= LANES) {
+            // voies: LANES etats consecutifs, qui avancent ensuite de LANES pas a la fois
+            uint128 a = multiplier(), aN = 1, cN = 0;
+            for (size_t l = 0; l < LANES; ++l) {
+                cN = cN * a + inc;
+                aN *= a;
+            }
+
+            uint128 lanes[LANES];
+            uint128 s = state;
+            for (size_t l = 0; l < LANES; ++l) {
+                s = s * a + inc;
+                lanes[l] = s;
+            }
+
+            for (; i + LANES <= n; i += LANES) {
+                for (size_t l = 0; l < LANES; ++l) {
+                    out[i + l] = toUnit(output(lanes[l]));
+                    state = lanes[l];
+                    lanes[l] = lanes[l] * aN + cN;
+                }
+            }
+        }
+
+        while (i < n) {
+            out[i++] = toUnit((*this)());
+        }
+    }
+};
+
+/**
+ * Philox4x64-10 (Salmon et al., Random123): generateur base sur un compteur de 256 bits chiffre par 10 tours d'un
+ * reseau de Feistel avec une cle de 128 bits (choisie par la graine). Chaque valeur du compteur donne 4 valeurs.
+ *
+ * Les blocs d'un lot sont independants (compteurs consecutifs): ils sont chiffres LANES par LANES.
+ */
+class Philox4x64 {
+public:
+    typedef uint64_t result_type;
+
+    static const size_t LANES = 4; // nombre de blocs de 4 valeurs chiffres ensemble
+
+private:
+    static const uint64_t M0 = 0xD2E7470EE14C6C93ULL, M1 = 0xCA5A826395121157ULL;
+    static const uint64_t W0 = 0x9E3779B97F4A7C15ULL, W1 = 0xBB67AE8584CAA73BULL;
+
+    uint64_t key[2];
+    uint64_t counter[4];
+    uint64_t buffered[4];  // valeurs du dernier bloc
+    size_t next = 4;       // indice de la prochaine valeur a rendre dans buffered
+
+    static void mulhilo(uint64_t a, uint64_t b, uint64_t& hi, uint64_t& lo) {
+#ifdef __SIZEOF_INT128__
+        __extension__ typedef unsigned __int128 uint128;
+        uint128 p = (uint128)a * b;
+        hi = (uint64_t)(p >> 64);
+        lo = (uint64_t)p;
+#else
+        // produit par moities de 32 bits
+        uint64_t aLo = a & 0xFFFFFFFFULL, aHi = a >> 32;
+        uint64_t bLo = b & 0xFFFFFFFFULL, bHi = b >> 32;
+        uint64_t ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+        uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFULL) + (hl & 0xFFFFFFFFULL);
+        hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+        lo = (mid << 32) | (ll & 0xFFFFFFFFULL);
+#endif
+    }
+
+    /**
+     * Chiffre un compteur.
+     *
+     * @param ctr Le compteur, remplace par le bloc chiffre.
+     */
+    void encrypt(uint64_t* ctr) const {
+        uint64_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; ++round) {
+            uint64_t hi0, lo0, hi1, lo1;
+            mulhilo(M0, ctr[0], hi0, lo0);
+            mulhilo(M1, ctr[2], hi1, lo1);
+
+            uint64_t x0 = hi1 ^ ctr[1] ^ k0, x2 = hi0 ^ ctr[3] ^ k1;
+            ctr[0] = x0;
+            ctr[1] = lo1;
+            ctr[2] = x2;
+            ctr[3] = lo0;
+
+            k0 += W0;
+            k1 += W1;
+        }
+    }
+
+    void increment() {
+        for (size_t j = 0; j < 4 && ++counter[j] == 0; ++j) {
+        }
+    }
+
+public:
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return ~(result_type)0;
+    }
+
+    Philox4x64() {
+        std::seed_seq seq;
+        seed(seq);
+    }
+
+    void seed(std::seed_seq& seq) {
+        uint32_t words[4];
+        seq.generate(words, words + 4);
+        seed((uint64_t)words[0] << 32 | words[1], (uint64_t)words[2] << 32 | words[3]);
+    }
+
+    /**
+     * Initialise la cle et remet le compteur a 0.
+     */
+    void seed(uint64_t key0, uint64_t key1) {
+        key[0] = key0;
+        key[1] = key1;
+        counter[0] = counter[1] = counter[2] = counter[3] = 0;
+        next = 4;
+    }
+
+    /**
+     * Place le compteur sur un bloc donne (saut direct: le bloc c donne les valeurs 4c a 4c + 3).
+     *
+     * @param ctr Les 4 mots du compteur, du poids faible au poids fort.
+     */
+    void setCounter(const uint64_t ctr[4]) {
+        for (size_t j = 0; j < 4; ++j) {
+            counter[j] = ctr[j];
+        }
+        next = 4;
+    }
+
+    result_type operator()() {
+        if (next == 4) {
+            for (size_t j = 0; j < 4; ++j) {
+                buffered[j] = counter[j];
+            }
+            encrypt(buffered);
+            increment();
+            next = 0;
+        }
+        return buffered[next++];
+    }
+
+    /**
+     * Remplit un tampon de realisations U(0,1) (voir toUnit).
+     */
+    void fill(double* out, size_t n) {
+        size_t i = 0;
+        while (i < n && next < 4) {
+            out[i++] = toUnit(buffered[next++]);
+        }
+
+        uint64_t blocks[LANES][4];
+        for (; i + 4 * LANES <= n; i += 4 * LANES) {
+            for (size_t l = 0; l < LANES; ++l) {
+                for (size_t j = 0; j < 4; ++j) {
+                    blocks[l][j] = counter[j];
+                }
+                increment();
+            }
+            for (size_t l = 0; l < LANES; ++l) {
+                encrypt(blocks[l]);
+            }
+            for (size_t l = 0; l < LANES; ++l) {
+                for (size_t j = 0; j < 4; ++j) {
+                    out[i + 4*l + j] = toUnit(blocks[l][j]);
+                }
+            }
+        }
+
+        while (i < n) {
+            out[i++] = toUnit((*this)());
+        }
+    }
+};
+
+#endif // ENGINES_H
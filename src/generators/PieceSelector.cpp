@@ -0,0 +1,98 @@
+#include <stdexcept>
+
+#include "PieceSelector.h"
+
+PieceSelector::PieceSelector(const std::vector<double>& probabilities, Method method)
+        : method(method), numPieces(probabilities.size()) {
+
+    if (probabilities.empty()) {
+        throw std::invalid_argument("Il faut au moins une tranche.");
+    }
+
+    if (method == Method::AUTO) {
+        this->method = numPieces < ALIAS_THRESHOLD ? Method::GUIDE : Method::ALIAS;
+    }
+
+    last = 0;
+    for (uint64_t k = 0; k < numPieces; ++k) {
+        if (probabilities[k] > 0) {
+            last = k;
+        }
+    }
+
+    if (this->method == Method::GUIDE) {
+        buildGuide(probabilities);
+    } else {
+        buildAlias(probabilities);
+    }
+}
+
+PieceSelector::Method PieceSelector::getMethod() const {
+    return method;
+}
+
+bool PieceSelector::isMonotone() const {
+    return method == Method::GUIDE;
+}
+
+void PieceSelector::buildGuide(const std::vector<double>& probabilities) {
+    F_parts.resize(numPieces + 1);
+    F_parts[0] = 0;
+    for (uint64_t k = 1; k <= numPieces; ++k) {
+        F_parts[k] = F_parts[k-1] + probabilities[k-1];
+    }
+
+    // guide[j] = plus petit k tel que F_parts[k+1] > j / K (ou la derniere tranche si les arrondis l'empechent)
+    guide.resize(numPieces + 1);
+    uint64_t k = 0;
+    for (uint64_t j = 0; j <= numPieces; ++j) {
+        double u = (double)j / numPieces;
+        while (k < last && F_parts[k+1] <= u) {
+            ++k;
+        }
+        guide[j] = k;
+    }
+}
+
+void PieceSelector::buildAlias(const std::vector<double>& probabilities) {
+    double total = 0;
+    for (double p : probabilities) {
+        total += p;
+    }
+
+    // probabilites mises a l'echelle: une case "pleine" vaut 1
+    std::vector<double> scaled(numPieces);
+    std::vector<uint64_t> small, large;
+    for (uint64_t k = 0; k < numPieces; ++k) {
+        scaled[k] = probabilities[k] / total * numPieces;
+        if (scaled[k] < 1) {
+            small.push_back(k);
+        } else {
+            large.push_back(k);
+        }
+    }
+
+    cells.resize(numPieces);
+
+    // chaque case "petite" est completee par une part d'une case "grande"
+    while (!small.empty() && !large.empty()) {
+        uint64_t s = small.back(), l = large.back();
+        small.pop_back();
+
+        cells[s] = {scaled[s], l};
+        scaled[l] = (scaled[l] + scaled[s]) - 1;
+
+        if (scaled[l] < 1) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // les cases restantes sont pleines (aux arrondis pres)
+    for (uint64_t k : large) {
+        cells[k] = {1, k};
+    }
+    for (uint64_t k : small) {
+        cells[k] = scaled[k] > 0 ? AliasCell{1, k} : AliasCell{0, last};
+    }
+}
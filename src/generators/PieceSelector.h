@@ -0,0 +1,123 @@
+#ifndef PIECE_SELECTOR_H
+#define PIECE_SELECTOR_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Selectionne l'indice k d'une "tranche" avec probabilite p_k a partir d'une realisation d'une U(0,1), en temps
+ * constant (independant du nombre de tranches K).
+ *
+ * Deux methodes sont disponibles:
+ * - GUIDE: table guide (Chen-Asau) sur la fonction de repartition, puis recherche dichotomique dans l'intervalle
+ *   indique par la table. Le resultat est celui de l'inversion de la fonction de repartition (k croissant avec U):
+ *   le plus petit k tel que U < F_parts[k+1]. Une tranche de probabilite nulle n'est donc jamais selectionnee.
+ * - ALIAS: methode des alias de Walker (construction de Vose). Une seule lecture aleatoire en memoire par tirage,
+ *   mais k n'est plus monotone en U.
+ *
+ * Par defaut (AUTO), la table guide est utilisee pour un petit nombre de tranches (elle tient en cache et donne les
+ * memes indices que l'inversion) et la methode des alias au-dela de ALIAS_THRESHOLD tranches.
+ */
+class PieceSelector {
+public:
+    enum class Method { AUTO, GUIDE, ALIAS };
+
+    // nombre de tranches a partir duquel AUTO choisit la methode des alias
+    static const size_t ALIAS_THRESHOLD = 4096;
+
+private:
+    /**
+     * Case de la table des alias: avec probabilite "threshold" on garde la case, sinon on prend l'alias.
+     */
+    struct AliasCell {
+        double threshold;
+        uint64_t alias;
+    };
+
+    Method method;                  // methode effectivement utilisee (jamais AUTO)
+    size_t numPieces;               // nombre de tranches K
+
+    std::vector<double> F_parts;    // fonction de repartition (K+1 valeurs), pour GUIDE
+    std::vector<uint64_t> guide;    // guide[j] = plus petit k tel que F_parts[k+1] > j / K, pour GUIDE
+    std::vector<AliasCell> cells;   // table des alias, pour ALIAS
+    uint64_t last;                  // derniere tranche de probabilite non nulle (garde-fou pour les arrondis)
+
+public:
+    /**
+     * Construit les tables.
+     *
+     * @param probabilities Les probabilites p_k des tranches (somme egale a 1, aux arrondis pres).
+     * @param method La methode a utiliser.
+     */
+    PieceSelector(const std::vector<double>& probabilities, Method method = Method::AUTO);
+
+    /**
+     * Selectionne une tranche.
+     *
+     * @param U Une realisation d'une U(0,1).
+     * @return L'indice de la tranche selectionnee.
+     */
+    uint64_t select(double U) const {
+        return method == Method::ALIAS ? selectAlias(U) : selectGuide(U);
+    }
+
+    /**
+     * @return La methode effectivement utilisee (GUIDE ou ALIAS).
+     */
+    Method getMethod() const;
+
+    /**
+     * @return Si l'indice selectionne est croissant en U (inversion de la fonction de repartition).
+     */
+    bool isMonotone() const;
+
+private:
+    /**
+     * @see select, methode GUIDE.
+     */
+    uint64_t selectGuide(double U) const {
+        size_t j = (size_t)(U * numPieces);
+        if (j >= numPieces) {
+            j = numPieces - 1;
+        }
+
+        // la tranche cherchee est entre guide[j] et guide[j+1]
+        uint64_t first = guide[j], lastK = guide[j + 1];
+        while (first < lastK) {
+            uint64_t mid = (lastK - first) / 2 + first;
+            if (U < F_parts[mid + 1]) {
+                lastK = mid;
+            } else {
+                first = mid + 1;
+            }
+        }
+        return first;
+    }
+
+    /**
+     * @see select, methode ALIAS.
+     */
+    uint64_t selectAlias(double U) const {
+        double scaled = U * numPieces;
+        size_t j = (size_t)scaled;
+        if (j >= numPieces) {
+            j = numPieces - 1;
+        }
+
+        const AliasCell& cell = cells[j];
+        return scaled - j < cell.threshold ? j : cell.alias;
+    }
+
+    /**
+     * Construit la table guide.
+     */
+    void buildGuide(const std::vector<double>& probabilities);
+
+    /**
+     * Construit la table des alias (algorithme de Vose).
+     */
+    void buildAlias(const std::vector<double>& probabilities);
+};
+
+#endif // PIECE_SELECTOR_H
@@ -0,0 +1,201 @@
+#ifndef RANDOM_ENGINE_H
+#define RANDOM_ENGINE_H
+
+#include <random>
+#include <vector>
+#include <limits>
+#include <iterator>
+#include <cstdint>
+#include <cstddef>
+
+#include "Engines.h"
+
+/**
+ * Generateur de nombres pseudo-aleatoires utilise par les methodes et les generateurs de variables aleatoires.
+ *
+ * L'algorithme est choisi a l'execution (voir Kind): std::mt19937_64 par defaut, ou l'un des generateurs plus
+ * rapides de Engines.h. Le choix n'est verifie qu'une fois par lot lors d'un remplissage (voir fill). Respecte
+ * l'interface d'un generateur de la bibliotheque standard.
+ */
+class RandomEngine {
+public:
+    typedef uint64_t result_type;
+
+    enum class Kind { MT19937_64, XOSHIRO256PP, PCG64, PHILOX4X64 };
+
+private:
+    Kind kind;
+    std::mt19937_64 mt;
+    Xoshiro256PlusPlus xoshiro;
+    Pcg64 pcg;
+    Philox4x64 philox;
+
+public:
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return ~(result_type)0;
+    }
+
+    /**
+     * @param kind L'algorithme a utiliser.
+     */
+    explicit RandomEngine(Kind kind = Kind::MT19937_64) : kind(kind) {}
+
+    /**
+     * @param seed La graine.
+     * @param kind L'algorithme a utiliser.
+     */
+    explicit RandomEngine(result_type seed, Kind kind = Kind::MT19937_64) : kind(kind) {
+        std::seed_seq seq = {(uint32_t)seed, (uint32_t)(seed >> 32)};
+        if (kind == Kind::MT19937_64) {
+            mt.seed(seed);
+        } else {
+            this->seed(seq);
+        }
+    }
+
+    /**
+     * @return L'algorithme utilise.
+     */
+    Kind getKind() const {
+        return kind;
+    }
+
+    void seed(std::seed_seq& seq) {
+        switch (kind) {
+            case Kind::MT19937_64: mt.seed(seq); break;
+            case Kind::XOSHIRO256PP: xoshiro.seed(seq); break;
+            case Kind::PCG64: pcg.seed(seq); break;
+            case Kind::PHILOX4X64: philox.seed(seq); break;
+        }
+    }
+
+    result_type operator()() {
+        switch (kind) {
+            case Kind::XOSHIRO256PP: return xoshiro();
+            case Kind::PCG64: return pcg();
+            case Kind::PHILOX4X64: return philox();
+            default: return mt();
+        }
+    }
+
+    /**
+     * Genere une realisation d'une variable aleatoire U(0,1): std::generate_canonical pour std::mt19937_64 (comme
+     * std::uniform_real_distribution), conversion par copie de bits pour les autres (voir toUnit).
+     */
+    double uniform() {
+        switch (kind) {
+            case Kind::XOSHIRO256PP: return toUnit(xoshiro());
+            case Kind::PCG64: return toUnit(pcg());
+            case Kind::PHILOX4X64: return toUnit(philox());
+            default: return std::generate_canonical<double, std::numeric_limits<double>::digits>(mt);
+        }
+    }
+
+    /**
+     * Remplit un tampon de realisations U(0,1), dans l'ordre ou uniform les aurait generees.
+     */
+    void fill(double* out, size_t n) {
+        switch (kind) {
+            case Kind::XOSHIRO256PP: xoshiro.fill(out, n); break;
+            case Kind::PCG64: pcg.fill(out, n); break;
+            case Kind::PHILOX4X64: philox.fill(out, n); break;
+            default:
+                for (size_t i = 0; i < n; ++i) {
+                    out[i] = std::generate_canonical<double, std::numeric_limits<double>::digits>(mt);
+                }
+        }
+    }
+};
+
+/**
+ * Genere une realisation d'une variable aleatoire U(0,1).
+ *
+ * Equivalent a std::uniform_real_distribution<double>(0, 1), mais sans etat: peut etre appelee depuis une methode
+ * constante avec un generateur propre a chaque thread.
+ *
+ * @param engine Le generateur a utiliser.
+ * @return La realisation generee.
+ */
+inline double uniform01(RandomEngine& engine) {
+    return engine.uniform();
+}
+
+// nombre de valeurs traitees par lot par les generateurs et les methodes (tampons sur la pile)
+const size_t BATCH_SIZE = 256;
+
+/**
+ * Remplit un tampon avec des realisations d'une variable aleatoire U(0,1), dans l'ordre ou uniform01 les aurait
+ * generees.
+ *
+ * @param engine Le generateur a utiliser.
+ * @param out Le tampon a remplir.
+ * @param n Le nombre de realisations a generer.
+ */
+inline void fillUniform(RandomEngine& engine, double* out, size_t n) {
+    engine.fill(out, n);
+}
+
+/**
+ * Extrait les parametres d'une graine (std::seed_seq n'est pas copiable).
+ *
+ * @param seed La graine.
+ * @return Les parametres de la graine.
+ */
+inline std::vector<uint32_t> seedParams(const std::seed_seq& seed) {
+    std::vector<uint32_t> params;
+    params.reserve(seed.size());
+    seed.param(std::back_inserter(params));
+    return params;
+}
+
+/**
+ * Initialise un generateur avec une graine donnee (l'algorithme du generateur est conserve).
+ *
+ * @param engine Le generateur a initialiser.
+ * @param seed La graine a utiliser.
+ */
+inline void seedEngine(RandomEngine& engine, const std::seed_seq& seed) {
+    std::vector<uint32_t> params = seedParams(seed);
+    std::seed_seq copy(params.begin(), params.end());
+    engine.seed(copy);
+}
+
+/**
+ * Initialise un generateur sur le flux d'indice donne derive d'une graine. Deux indices differents donnent deux
+ * flux independants, et un meme couple (graine, indice) donne toujours le meme flux.
+ *
+ * @param engine Le generateur a initialiser.
+ * @param seedKey Les parametres de la graine (voir seedParams).
+ * @param index L'indice du flux.
+ */
+inline void seedStream(RandomEngine& engine, const std::vector<uint32_t>& seedKey, uint64_t index) {
+    std::vector<uint32_t> params(seedKey);
+    params.push_back((uint32_t)index);
+    params.push_back((uint32_t)(index >> 32));
+    params.push_back(0x9E3779B9u); // separe les flux des graines "utilisateur" de meme longueur
+    std::seed_seq seq(params.begin(), params.end());
+    engine.seed(seq);
+}
+
+/**
+ * Derive d'une graine les parametres de la graine du processus de calcul d'indice donne (mode reparti, voir
+ * MonteCarloMethod::setNumProcesses). Les flux obtenus sont independants de ceux des shards (voir seedStream) et des
+ * autres processus.
+ *
+ * @param seedKey Les parametres de la graine (voir seedParams).
+ * @param index L'indice du processus.
+ * @return Les parametres de la graine du processus.
+ */
+inline std::vector<uint32_t> workerSeedParams(const std::vector<uint32_t>& seedKey, uint64_t index) {
+    std::vector<uint32_t> params(seedKey);
+    params.push_back((uint32_t)index);
+    params.push_back((uint32_t)(index >> 32));
+    params.push_back(0x85EBCA6Bu);
+    return params;
+}
+
+#endif // RANDOM_ENGINE_H
@@ -1,127 +1,421 @@
+#include <cmath>
 #include <algorithm>
+#include <stdexcept>
 
 #include "../utility/Checker.h"
 #include "RandomValueGenerator.h"
+#include "../utility/Profiler.h"
 
-RandomValueGenerator::RandomValueGenerator(const std::vector<double>& xs, const std::vector<double>& ys)
-            : func(xs, ys), distribution(std::uniform_real_distribution<double>(0, 1)) {
+RandomValueGenerator::RandomValueGenerator(const std::vector<double>& xs, const std::vector<double>& ys,
+                                           PieceSelector::Method method)
+            : func(checked(xs, ys), ys), selector(probabilities(func), method) {
+    computeDistribution();
+}
+
+void RandomValueGenerator::setPoints(const std::vector<double>& xs, const std::vector<double>& ys) {
+    func = PiecewiseLinearFunction(checked(xs, ys), ys);
+    selector = PieceSelector(probabilities(func), selector.getMethod());
+    computeDistribution();
+}
+
+void RandomValueGenerator::computeDistribution() {
+
+    // préparation des parties de F
+    F_parts.resize(func.xs.size());
+    F_parts[0] = 0; // F_0 : premiere partie de la fonction de repartition -> 0 avant xs[0]
+
+    for (uint64_t i = 1; i < F_parts.size(); ++i) {
+        F_parts[i] = F_parts[i-1] + func.area(i-1)/func.A;
+    }
+}
+
+const std::vector<double>& RandomValueGenerator::checked(const std::vector<double>& xs, const std::vector<double>& ys) {
 
     // verification de la coherence des donnees
     if (!Checker::check(xs, ys)) {
         throw std::invalid_argument("Erreur: Les donnees ne sont pas coherentes.");
     }
+    return xs;
+}
+
+std::vector<double> RandomValueGenerator::probabilities(const PiecewiseLinearFunction& func) {
 
     // creation des pk
     std::vector<double> pks;
-    pks.reserve(xs.size()-1);
-    for (uint64_t i = 0; i < xs.size()-1; ++i) {
-        pks.push_back(func.pieces[i].A_k/func.A);
+    pks.reserve(func.size());
+    for (uint64_t k = 0; k < func.size(); ++k) {
+        pks.push_back(func.area(k)/func.A);
     }
+    return pks;
+}
 
-    // préparation des parties de F
-    F_parts.resize(xs.size());
-    F_parts[0] = 0; // F_0 : premiere partie de la fonction de repartition -> 0 avant xs[0]
+void RandomValueGenerator::setSeed(const std::seed_seq& seed) {
+    seedEngine(generator, seed);
+    seedKey = seedParams(seed);
+}
 
-    for (uint64_t i = 1; i < F_parts.size(); ++i) {
-        F_parts[i] = F_parts[i-1] + pks[i-1];
+void RandomValueGenerator::setEngine(RandomEngine::Kind kind) {
+    generator = RandomEngine(kind);
+
+    if (!seedKey.empty()) {
+        std::seed_seq seed(seedKey.begin(), seedKey.end());
+        generator.seed(seed);
     }
 }
 
-void RandomValueGenerator::setSeed(std::seed_seq seed) {
-    generator.seed(seed);
+double RandomValueGenerator::generate() {
+    return generate(generator);
 }
 
-uint64_t RandomValueGenerator::generateK() {
-    uint64_t j = 1;
-    double U = distribution(generator);
+void RandomValueGenerator::generateBatch(double* out, size_t n) {
+    generateBatch(generator, out, n);
+}
 
-    // on cherche l'indice de l'intervalle dans lequel on est tombe
-    while (true) {
-        if (U <= F_parts[j]) {
-            return j-1;
-        }
-        ++j;
-    }
+uint64_t RandomValueGenerator::generateK(RandomEngine& engine) const {
+    return selectPiece(uniform01(engine));
+}
+
+uint64_t RandomValueGenerator::selectPiece(double U) const {
+    // on cherche l'indice de l'intervalle dans lequel on est tombe, en temps constant
+    return selector.select(U);
+}
+
+PieceSelector::Method RandomValueGenerator::getSelectionMethod() const {
+    return selector.getMethod();
 }
 
 const PiecewiseLinearFunction& RandomValueGenerator::getPWLFunc() const {
     return func;
 }
 
-HitOrMiss::HitOrMiss(const std::vector<double>& xs, const std::vector<double>& ys)
-        : RandomValueGenerator(xs, ys) {
+HitOrMiss::HitOrMiss(const std::vector<double>& xs, const std::vector<double>& ys, PieceSelector::Method method)
+        : RandomValueGenerator(xs, ys, method) {
     a = xs.front(), b = xs.back();
     yMax = *std::max_element(ys.begin(), ys.end());
 }
 
-Geometric::Geometric(const std::vector<double>& xs, const std::vector<double>& ys)
-        : RandomValueGenerator(xs, ys) {}
+void HitOrMiss::setPoints(const std::vector<double>& xs, const std::vector<double>& ys) {
+    RandomValueGenerator::setPoints(xs, ys);
+    a = xs.front(), b = xs.back();
+    yMax = *std::max_element(ys.begin(), ys.end());
+}
+
+void HitOrMiss::setTelemetry(Telemetry* telemetry) {
+    this->telemetry = telemetry;
+}
+
+EnvelopeRejection::EnvelopeRejection(const std::vector<double>& xs, const std::vector<double>& ys,
+                                     PieceSelector::Method method, unsigned subdivisions)
+        : RandomValueGenerator(xs, ys, method), shift(checkedShift(subdivisions)),
+          cellSelector(computeEnvelopes(), method) {}
+
+unsigned EnvelopeRejection::checkedShift(unsigned subdivisions) {
+    if (subdivisions == 0 || (subdivisions & (subdivisions - 1)) != 0) {
+        throw std::invalid_argument("Le nombre de cellules par morceau doit etre une puissance de 2.");
+    }
+
+    unsigned shift = 0;
+    while ((1u << shift) < subdivisions) {
+        ++shift;
+    }
+    return shift;
+}
+
+void EnvelopeRejection::setPoints(const std::vector<double>& xs, const std::vector<double>& ys) {
+    RandomValueGenerator::setPoints(xs, ys);
+    cellSelector = PieceSelector(computeEnvelopes(), cellSelector.getMethod());
+}
+
+std::vector<double> EnvelopeRejection::computeEnvelopes() {
+    uint64_t subdivisions = uint64_t(1) << shift;
+
+    lines.resize(func.size());
+    std::vector<double> areas(func.size() * subdivisions);
+    double totalArea = 0, squeezeArea = 0;
+
+    for (uint64_t k = 0; k < func.size(); ++k) {
+        Piece piece = func.piece(k);
+        double width = piece.x1 - piece.x0;
+        lines[k] = {piece.x0, width / subdivisions, piece.y0, (piece.y1 - piece.y0) / width};
+
+        for (uint64_t j = 0; j < subdivisions; ++j) {
+            double ya = lines[k].slope * (j * lines[k].cellWidth) + piece.y0;
+            double yb = lines[k].slope * lines[k].cellWidth + ya;
+
+            areas[k * subdivisions + j] = std::max(ya, yb) * lines[k].cellWidth;
+            totalArea += areas[k * subdivisions + j];
+            squeezeArea += std::min(ya, yb) * lines[k].cellWidth;
+        }
+    }
+
+    acceptanceRate = func.A / totalArea;
+    squeezeRate = squeezeArea / totalArea;
+
+    for (double& area : areas) {
+        area /= totalArea;
+    }
+    return areas;
+}
+
+void EnvelopeRejection::setTelemetry(Telemetry* telemetry) {
+    this->telemetry = telemetry;
+}
+
+double EnvelopeRejection::getAcceptanceRate() const {
+    return acceptanceRate;
+}
+
+double EnvelopeRejection::getSqueezeRate() const {
+    return squeezeRate;
+}
+
+Geometric::Geometric(const std::vector<double>& xs, const std::vector<double>& ys, PieceSelector::Method method)
+        : RandomValueGenerator(xs, ys, method) {}
+
+InverseFunctions::InverseFunctions(const std::vector<double>& xs, const std::vector<double>& ys, PieceSelector::Method method)
+        : RandomValueGenerator(xs, ys, method) {}
+
+void InverseFunctions::setPoints(const std::vector<double>& xs, const std::vector<double>& ys) {
+    RandomValueGenerator::setPoints(xs, ys);
+    if (resolution > 0) {
+        buildTable();
+    }
+}
+
+void InverseFunctions::setTableResolution(size_t resolution) {
+    this->resolution = resolution;
+    if (resolution > 0) {
+        buildTable();
+    } else {
+        cells.clear();
+        table.clear();
+    }
+}
+
+size_t InverseFunctions::getTableResolution() const {
+    return resolution;
+}
 
-InverseFunctions::InverseFunctions(const std::vector<double>& xs, const std::vector<double>& ys)
-        : RandomValueGenerator(xs, ys) {}
+void InverseFunctions::buildTable() {
+    uint64_t numPieces = func.size();
+
+    // inversion de chaque morceau: les morceaux de probabilite nulle ne sont jamais choisis
+    cells.resize(numPieces);
+    lastPiece = 0;
+    for (uint64_t k = 0; k < numPieces; ++k) {
+        Piece piece = func.piece(k);
+        double pk = F_parts[k+1] - F_parts[k];
+        double alpha = pk > 0 ? (piece.y0 + piece.y1) / pk : 0;
+
+        cells[k] = {F_parts[k], piece.x0, piece.x1, (piece.x1 - piece.x0) * alpha, piece.y0, piece.y0 * piece.y0,
+                    (piece.y1 - piece.y0) * alpha};
+        if (pk > 0) {
+            lastPiece = k;
+        }
+    }
+
+    // table[j] = plus petit k tel que F_parts[k+1] > j / resolution (ou le dernier morceau si les arrondis l'empechent)
+    table.resize(resolution + 1);
+    uint64_t k = 0;
+    for (size_t j = 0; j <= resolution; ++j) {
+        double u = (double)j / resolution;
+        while (k < lastPiece && F_parts[k+1] <= u) {
+            ++k;
+        }
+        table[j] = k;
+    }
+}
 
 
-double HitOrMiss::generate() {
+double HitOrMiss::generate(RandomEngine& engine) const {
 
     double X, Y; // coordonnees du point (X,Y) qui sera genere
-    uint64_t sliceIndex;  // indice de la "tranche" dans laquelle X se trouvera
+    uint64_t trials = 0;
 
     do {
         // generation du point (X,Y)
-        X = distribution(generator) * (b - a) + a;
-        Y = distribution(generator) * yMax;
+        X = uniform01(engine) * (b - a) + a;
+        Y = uniform01(engine) * yMax;
+        ++trials;
 
         // rejet si Y est > que f(X)
     } while (Y > func(X));
 
+    if (telemetry) {
+        telemetry->addTrials(trials, 1);
+    }
+    return X;
+}
+
+void HitOrMiss::generateBatch(RandomEngine& engine, double* out, size_t n) const {
+    double us[2 * BATCH_SIZE];
+
+    size_t done = 0;
+    uint64_t trials = 0;
+    while (done < n) {
+        // generation d'un lot de points (X,Y) candidats, dans le meme ordre que generate. Au plus n - done candidats:
+        // chacun donne au plus une valeur, donc tous sont utilises et le flux reste celui des appels a generate
+        size_t m = std::min(BATCH_SIZE, n - done);
+        SIO_PROFILE_BATCH(m);
+        fillUniform(engine, us, 2 * m);
+        SIO_PROFILE_MARK(UNIFORM);
+
+        for (size_t i = 0; i < m; ++i) {
+            double X = us[2*i] * (b - a) + a;
+            double Y = us[2*i + 1] * yMax;
+
+            // rejet si Y est > que f(X)
+            if (Y <= func(X)) {
+                out[done++] = X;
+            }
+        }
+        trials += m;
+        SIO_PROFILE_MARK(TRANSFORM);
+    }
+
+    if (telemetry) {
+        telemetry->addTrials(trials, n);
+    }
+}
+
+
+double EnvelopeRejection::generate(RandomEngine& engine) const {
+    double X;
+    uint64_t trials = 0;
+    bool accepted;
+
+    // cellule choisie selon l'aire de son enveloppe, puis point (X,Y) uniforme sous l'enveloppe
+    do {
+        uint64_t cell = cellSelector.select(uniform01(engine));
+        double U = uniform01(engine);
+        double V = uniform01(engine);
+        accepted = propose(cell, U, V, X);
+        ++trials;
+    } while (!accepted);
+
+    if (telemetry) {
+        telemetry->addTrials(trials, 1);
+    }
     return X;
 }
 
+void EnvelopeRejection::generateBatch(RandomEngine& engine, double* out, size_t n) const {
+    double us[3 * BATCH_SIZE];
+    uint64_t cells[BATCH_SIZE];
+
+    size_t done = 0;
+    uint64_t trials = 0;
+    while (done < n) {
+        // generation d'un lot de points (K,X,Y) candidats, dans le meme ordre que generate: au plus n - done
+        // candidats, de sorte que le lot ne depasse jamais la n-ieme acceptation
+        size_t m = std::min(BATCH_SIZE, n - done);
+        SIO_PROFILE_BATCH(m);
+        fillUniform(engine, us, 3 * m);
+        SIO_PROFILE_MARK(UNIFORM);
+
+        for (size_t i = 0; i < m; ++i) {
+            cells[i] = cellSelector.select(us[3*i]);
+        }
+        SIO_PROFILE_MARK(SELECT_PIECE);
+
+        for (size_t i = 0; i < m; ++i) {
+            double X;
+            if (propose(cells[i], us[3*i + 1], us[3*i + 2], X)) {
+                out[done++] = X;
+            }
+        }
+        trials += m;
+        SIO_PROFILE_MARK(TRANSFORM);
+    }
+
+    if (telemetry) {
+        telemetry->addTrials(trials, n);
+    }
+}
 
-double Geometric::generate() {
+double Geometric::generate(RandomEngine& engine) const {
 
     // On commence par selectionner un intervalle en fonction des p_k des "tranches" de la fonction.
     // K represente l'indice de l'intervalle selectionne.
-    uint64_t K = generateK();
+    uint64_t K = generateK(engine);
 
 
     // Ensuite, on genere une realisation d'une variable de densite f_K en acceptant a tous les coups X.
 
     // morceau associe a l'indice K
-    const Piece& piece = func.pieces[K];
+    Piece piece = func.piece(K);
 
     // valeurs relatives au morceau de fonction K
     double x0 = piece.x0, x1 = piece.x1;
     double yMax = std::max(piece.y0, piece.y1);
 
     // generation du point (X,Y)
-    double X = distribution(generator) * (x1 - x0) + x0;
-    double Y = distribution(generator) * yMax;
+    double X = uniform01(engine) * (x1 - x0) + x0;
+    double Y = uniform01(engine) * yMax;
 
     // Si Y est sous f_K, ok, on retourne X. Sinon, on applique une symetrie à X et on le retourne.
-    if (Y <= piece.f_k(X)) {
+    if (Y <= func.evalPiece(K, X)) {
         return X;
     } else {
         return x0 + (x1 - X);
     }
 }
 
-double InverseFunctions::generate() {
+void Geometric::generateBatch(RandomEngine& engine, double* out, size_t n) const {
+    double us[3 * BATCH_SIZE];
+    uint64_t ks[BATCH_SIZE];
+
+    for (size_t done = 0; done < n; done += BATCH_SIZE) {
+        size_t m = std::min(BATCH_SIZE, n - done);
+        double* res = out + done;
+
+        SIO_PROFILE_BATCH(m);
+
+        // 3 uniformes par realisation (K, X, Y), dans le meme ordre que generate
+        fillUniform(engine, us, 3 * m);
+        SIO_PROFILE_MARK(UNIFORM);
+
+        for (size_t i = 0; i < m; ++i) {
+            ks[i] = selectPiece(us[3*i]);
+        }
+        SIO_PROFILE_MARK(SELECT_PIECE);
+
+        for (size_t i = 0; i < m; ++i) {
+            Piece piece = func.piece(ks[i]);
+            double x0 = piece.x0, x1 = piece.x1;
+            double yMax = std::max(piece.y0, piece.y1);
+
+            double X = us[3*i + 1] * (x1 - x0) + x0;
+            double Y = us[3*i + 2] * yMax;
+
+            res[i] = Y <= func.evalPiece(ks[i], X) ? X : x0 + (x1 - X);
+        }
+        SIO_PROFILE_MARK(TRANSFORM);
+    }
+}
+
+double InverseFunctions::generate(RandomEngine& engine) const {
+
+    // mode table: une seule uniforme, inversee directement
+    if (resolution > 0) {
+        double u = uniform01(engine);
+        return tableInverse(tablePiece(u), u);
+    }
 
     // On commence par selectionner un intervalle en fonction des p_k des "tranches" de la fonction.
     // K represente l'indice de l'intervalle selectionne.
-    uint64_t K = generateK();
+    uint64_t K = generateK(engine);
 
     // Ensuite, on applique la methode des fonctions inverses.
 
     // morceau associe a l'indice K
-    const Piece& piece = func.pieces[K];
+    Piece piece = func.piece(K);
 
     // valeurs relatives au morceau de fonction K
     double x0 = piece.x0, x1 = piece.x1;
     double y0 = piece.y0, y1 = piece.y1;
 
-    double U = distribution(generator);
+    double U = uniform01(engine);
 
     // Si y0 = y1, alors on est dans le cas d'une uniforme. Sinon, on inverse la fonction de repartition associee
     // a la fonction f_K.
@@ -132,3 +426,99 @@ double InverseFunctions::generate() {
         return x0 + (sqrt( (y1*y1 - y0*y0) * U + y0*y0 ) - y0) / m;
     }
 }
+
+void InverseFunctions::generateBatch(RandomEngine& engine, double* out, size_t n) const {
+    double us[2 * BATCH_SIZE];
+    uint64_t ks[BATCH_SIZE];
+
+    // mode table: une uniforme par realisation, dans le meme ordre que generate
+    if (resolution > 0) {
+        for (size_t done = 0; done < n; done += BATCH_SIZE) {
+            size_t m = std::min(BATCH_SIZE, n - done);
+            double* res = out + done;
+
+            SIO_PROFILE_BATCH(m);
+            fillUniform(engine, us, m);
+            SIO_PROFILE_MARK(UNIFORM);
+
+            for (size_t i = 0; i < m; ++i) {
+                ks[i] = tablePiece(us[i]);
+            }
+            SIO_PROFILE_MARK(SELECT_PIECE);
+
+            for (size_t i = 0; i < m; ++i) {
+                res[i] = tableInverse(ks[i], us[i]);
+            }
+            SIO_PROFILE_MARK(TRANSFORM);
+        }
+        return;
+    }
+
+    for (size_t done = 0; done < n; done += BATCH_SIZE) {
+        size_t m = std::min(BATCH_SIZE, n - done);
+        double* res = out + done;
+
+        SIO_PROFILE_BATCH(m);
+
+        // 2 uniformes par realisation (K, U), dans le meme ordre que generate
+        fillUniform(engine, us, 2 * m);
+        SIO_PROFILE_MARK(UNIFORM);
+
+        for (size_t i = 0; i < m; ++i) {
+            ks[i] = selectPiece(us[2*i]);
+        }
+        SIO_PROFILE_MARK(SELECT_PIECE);
+
+        // les deux cas sont calcules puis selectionnes, sans branchement, pour permettre la vectorisation
+        for (size_t i = 0; i < m; ++i) {
+            Piece piece = func.piece(ks[i]);
+            double x0 = piece.x0, x1 = piece.x1;
+            double y0 = piece.y0, y1 = piece.y1;
+            double U = us[2*i + 1];
+
+            double slope = (y1 - y0)/(x1 - x0);
+            double uniform = x0 + U*(x1 - x0);
+            double inverse = x0 + (sqrt( (y1*y1 - y0*y0) * U + y0*y0 ) - y0) / slope;
+
+            res[i] = y0 == y1 ? uniform : inverse;
+        }
+        SIO_PROFILE_MARK(TRANSFORM);
+    }
+}
+
+double InverseFunctions::inverse(double u) const {
+
+    if (resolution > 0) {
+        return tableInverse(tablePiece(u), u);
+    }
+
+    // indice K de la tranche: plus petit k tel que u < F_k+1 (la methode des alias ne preserve pas l'ordre)
+    uint64_t K;
+    if (selector.isMonotone()) {
+        K = selectPiece(u);
+    } else {
+        K = std::upper_bound(F_parts.begin() + 1, F_parts.end() - 1, u) - (F_parts.begin() + 1);
+    }
+
+    // position relative de u dans la tranche, qui suit une U(0,1) conditionnellement a K
+    double pk = F_parts[K+1] - F_parts[K];
+    double U = pk > 0 ? (u - F_parts[K]) / pk : 0;
+    U = std::min(std::max(U, 0.0), 1.0);
+
+    Piece piece = func.piece(K);
+    double x0 = piece.x0, x1 = piece.x1;
+    double y0 = piece.y0, y1 = piece.y1;
+
+    if (y0 == y1) {
+        return x0 + U*(x1 - x0);
+    } else {
+        double m = (y1 - y0)/(x1 - x0);
+        return x0 + (sqrt( (y1*y1 - y0*y0) * U + y0*y0 ) - y0) / m;
+    }
+}
+
+void InverseFunctions::inverseBatch(const double* u, double* out, size_t n) const {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = inverse(u[i]);
+    }
+}
@@ -3,18 +3,24 @@
 
 #include <random>
 #include <vector>
+#include <algorithm>
+#include <cmath>
+#include "RandomEngine.h"
+#include "PieceSelector.h"
 #include "../utility/PiecewiseLinearFunction.h"
+#include "../utility/Telemetry.h"
 
 /**
  * Represente un generateur de realisations de variables aleatoires associees a une fonction affine par morceaux.
  */
 class RandomValueGenerator {
 protected:
-    std::mt19937_64 generator; // generateur mersenne-twister
-    std::uniform_real_distribution<double> distribution; // distribution a utiliser pour le mersenne-twister
+    RandomEngine generator; // generateur de nombres pseudo-aleatoires (mersenne-twister par defaut)
+    std::vector<uint32_t> seedKey; // parametres de la graine, conserves lors d'un changement d'algorithme
 
     PiecewiseLinearFunction func; // la fonction affine par morceaux que l'on utilise
     std::vector<double> F_parts; // parties de la fonction de repartition F
+    PieceSelector selector;      // selection de la tranche k en temps constant
 
 public:
     /**
@@ -22,36 +28,119 @@ public:
      *
      * @param xs Les abcsisses des points constituant la fonction affine par morceaux.
      * @param ys Les ordonnees des points constituant la fonction affine par morceaux.
+     * @param method La methode de selection des tranches (voir PieceSelector).
      */
-    RandomValueGenerator(const std::vector<double>& xs, const std::vector<double>& ys);
+    RandomValueGenerator(const std::vector<double>& xs, const std::vector<double>& ys,
+                         PieceSelector::Method method = PieceSelector::Method::AUTO);
+
+    virtual ~RandomValueGenerator() = default;
 
     /**
      * Initialise la graine du generateur.
      *
      * @param seed La graine a utiliser.
      */
-    void setSeed(std::seed_seq seed);
+    void setSeed(const std::seed_seq& seed);
+
+    /**
+     * Choisit l'algorithme du generateur de nombres pseudo-aleatoires. La graine deja donnee (voir setSeed) est
+     * conservee: le generateur est reinitialise avec elle.
+     *
+     * @param kind L'algorithme a utiliser (std::mt19937_64 par defaut).
+     */
+    void setEngine(RandomEngine::Kind kind);
+
+    /**
+     * Remplace la fonction affine par morceaux et reconstruit les tables (fonction de repartition, selection des
+     * tranches) en place, sans changer la methode de selection. Le cout est lineaire en le nombre de morceaux.
+     *
+     * @param xs Les abcsisses des points constituant la nouvelle fonction affine par morceaux.
+     * @param ys Les ordonnees des points constituant la nouvelle fonction affine par morceaux.
+     * @throw std::invalid_argument Si les donnees ne sont pas coherentes.
+     */
+    virtual void setPoints(const std::vector<double>& xs, const std::vector<double>& ys);
 
     /**
      * Genere une realisation d'une variable aleatoire associee a la fonction par morceaux.
      *
      * @return la variable aleatoire.
      */
-    virtual double generate() = 0;
+    double generate();
+
+    /**
+     * Genere une realisation d'une variable aleatoire associee a la fonction par morceaux a l'aide d'un generateur
+     * donne. Peut etre appelee simultanement depuis plusieurs threads (avec des generateurs differents).
+     *
+     * @param engine Le generateur a utiliser.
+     * @return la variable aleatoire.
+     */
+    virtual double generate(RandomEngine& engine) const = 0;
+
+    /**
+     * Genere n realisations de variables aleatoires associees a la fonction par morceaux.
+     *
+     * @param out Le tampon dans lequel ecrire les realisations.
+     * @param n Le nombre de realisations a generer.
+     */
+    void generateBatch(double* out, size_t n);
+
+    /**
+     * Genere n realisations de variables aleatoires associees a la fonction par morceaux a l'aide d'un generateur
+     * donne. Les uniformes sont tirees par lots puis transformees dans une boucle sans appel virtuel.
+     * Peut etre appelee simultanement depuis plusieurs threads (avec des generateurs differents).
+     *
+     * @param engine Le generateur a utiliser.
+     * @param out Le tampon dans lequel ecrire les realisations.
+     * @param n Le nombre de realisations a generer.
+     */
+    virtual void generateBatch(RandomEngine& engine, double* out, size_t n) const = 0;
 
     /**
      * Retourne la fonction affine par morceaux utilisee pour le generateur.
      */
     const PiecewiseLinearFunction& getPWLFunc() const;
 
+    /**
+     * Retourne la methode de selection des tranches effectivement utilisee.
+     */
+    PieceSelector::Method getSelectionMethod() const;
+
 protected:
     /**
      * Permet de trouver dans quel intervalle k on tombe en fonction de la probablilité p_k de la tranche liee a
      * cet intervalle.
      *
+     * @param engine Le generateur a utiliser.
      * @return l'indice de la tranche.
      */
-    uint64_t generateK();
+    uint64_t generateK(RandomEngine& engine) const;
+
+    /**
+     * Trouve l'indice de la tranche correspondant a une realisation donnee d'une U(0,1).
+     *
+     * @param U La realisation de la U(0,1).
+     * @return l'indice de la tranche.
+     */
+    uint64_t selectPiece(double U) const;
+
+private:
+    /**
+     * Verifie la coherence des donnees.
+     *
+     * @return Les abscisses, si les donnees sont coherentes.
+     * @throw std::invalid_argument Si les donnees ne sont pas coherentes.
+     */
+    static const std::vector<double>& checked(const std::vector<double>& xs, const std::vector<double>& ys);
+
+    /**
+     * Calcule les probabilites p_k = A_k / A des tranches.
+     */
+    static std::vector<double> probabilities(const PiecewiseLinearFunction& func);
+
+    /**
+     * Calcule les parties de la fonction de repartition a partir de la fonction affine par morceaux.
+     */
+    void computeDistribution();
 };
 
 
@@ -59,10 +148,11 @@ protected:
  *  Utilise une approche "bete et mechante" de la methode d'acceptation-rejet afin de generer des realisation de
  *  variables aleatoires.
  */
-class HitOrMiss : public RandomValueGenerator {
+class HitOrMiss final : public RandomValueGenerator {
 private:
     double a, b; // bornes min et max a prendre en compte pour la generation de l'abcisse du point
     double yMax; // maximum des ordonnees des points constituant "g" (utile pour la génération de l'ordonnee du point)
+    Telemetry* telemetry = nullptr; // compteurs des points proposes et acceptes (voir setTelemetry)
 
 public:
 
@@ -71,13 +161,161 @@ public:
      *
      * @param xs Les d'absisses des points constituant la fonction affine par morceaux.
      * @param ys Les ordonnees des points constituant la fonction affine par morceaux.
+     * @param method La methode de selection des tranches (voir PieceSelector).
+     */
+    HitOrMiss(const std::vector<double>& xs, const std::vector<double>& ys,
+              PieceSelector::Method method = PieceSelector::Method::AUTO);
+
+    using RandomValueGenerator::generate;
+    using RandomValueGenerator::generateBatch;
+
+    /**
+     * @see RandomValueGenerator::setPoints.
      */
-    HitOrMiss(const std::vector<double>& xs, const std::vector<double>& ys);
+    void setPoints(const std::vector<double>& xs, const std::vector<double>& ys);
+
+    /**
+     * Compte les points proposes et acceptes (une mise a jour par appel de generate ou generateBatch).
+     *
+     * @param telemetry Les compteurs (qui doivent rester valides pendant les generations), ou nullptr.
+     */
+    void setTelemetry(Telemetry* telemetry);
 
     /**
      *  Genere une realisation d'une variable aleatoire associee a la fonction par morceaux.
      */
-    double generate();
+    double generate(RandomEngine& engine) const;
+
+    /**
+     * @see RandomValueGenerator::generateBatch. Les candidats sont proposes par lots d'au plus n - done (nombre de
+     * valeurs manquantes): aucune uniforme n'est perdue, les valeurs et l'etat du generateur sont donc les memes
+     * qu'apres n appels a generate.
+     */
+    void generateBatch(RandomEngine& engine, double* out, size_t n) const;
+};
+
+
+/**
+ * Methode d'acceptation-rejet avec une enveloppe constante par cellule et une borne inferieure ("squeeze").
+ *
+ * Chaque morceau [x_k, x_k+1] est decoupe en cellules de meme largeur (voir subdivisions), sur lesquelles la fonction
+ * (affine) est majoree par sa valeur maximale et minoree par sa valeur minimale. Une cellule est choisie avec une
+ * probabilite proportionnelle a l'aire de son enveloppe, puis un point (X,Y) est tire uniformement sous l'enveloppe:
+ * s'il est sous la borne inferieure, il est accepte sans evaluer la fonction; sinon la fonction est evaluee sur le
+ * morceau deja connu (sans recherche du morceau). Contrairement a HitOrMiss (un seul rectangle de hauteur yMax), le
+ * taux d'acceptation ne depend pas de la forme globale de la fonction: il est d'au moins J / (J + 1) pour J cellules
+ * par morceau, et tend vers 1 pour une fonction reguliere.
+ */
+class EnvelopeRejection final : public RandomValueGenerator {
+public:
+    // nombre de cellules par morceau par defaut
+    static const unsigned DEFAULT_SUBDIVISIONS = 4;
+
+private:
+    /**
+     * Droite d'un morceau: la fonction y vaut y0 + slope * (x - x0) pour x dans [x0, x0 + subdivisions * cellWidth].
+     */
+    struct Line {
+        double x0, cellWidth;
+        double y0, slope;
+    };
+
+    std::vector<Line> lines;
+    unsigned shift;                  // log2 du nombre de cellules par morceau
+    double acceptanceRate;           // probabilite d'accepter un point propose
+    double squeezeRate;              // probabilite d'accepter un point propose sans evaluer la fonction
+    PieceSelector cellSelector;      // selection d'une cellule proportionnellement a l'aire de son enveloppe
+
+    Telemetry* telemetry = nullptr;  // compteurs des points proposes et acceptes (voir setTelemetry)
+
+public:
+    /**
+     * Initialise les enveloppes.
+     *
+     * @param xs Les abscisses des points constituant la fonction affine par morceaux.
+     * @param ys Les ordonnees des points constituant la fonction affine par morceaux.
+     * @param method La methode de selection des cellules (voir PieceSelector).
+     * @param subdivisions Le nombre de cellules par morceau (une puissance de 2): le taux d'acceptation augmente avec
+     *                     ce nombre, ainsi que la taille de la table de selection.
+     * @throw std::invalid_argument Si les donnees ne sont pas coherentes ou si subdivisions n'est pas une puissance
+     *                              de 2.
+     */
+    EnvelopeRejection(const std::vector<double>& xs, const std::vector<double>& ys,
+                      PieceSelector::Method method = PieceSelector::Method::AUTO,
+                      unsigned subdivisions = DEFAULT_SUBDIVISIONS);
+
+    using RandomValueGenerator::generate;
+    using RandomValueGenerator::generateBatch;
+
+    /**
+     * @see RandomValueGenerator::setPoints.
+     */
+    void setPoints(const std::vector<double>& xs, const std::vector<double>& ys);
+
+    /**
+     * Compte les points proposes et acceptes (une mise a jour par appel de generate ou generateBatch).
+     *
+     * @param telemetry Les compteurs (qui doivent rester valides pendant les generations), ou nullptr.
+     */
+    void setTelemetry(Telemetry* telemetry);
+
+    /**
+     * @return La probabilite qu'un point propose soit accepte (aire de la fonction / aire des enveloppes).
+     */
+    double getAcceptanceRate() const;
+
+    /**
+     * @return La probabilite qu'un point propose soit accepte sans evaluer la fonction (aire des bornes inferieures /
+     * aire des enveloppes).
+     */
+    double getSqueezeRate() const;
+
+    /**
+     * Genere une realisation d'une variable aleatoire associee a la fonction par morceaux.
+     */
+    double generate(RandomEngine& engine) const;
+
+    /**
+     * @see RandomValueGenerator::generateBatch.
+     */
+    void generateBatch(RandomEngine& engine, double* out, size_t n) const;
+
+private:
+    /**
+     * @return log2(subdivisions).
+     * @throw std::invalid_argument Si subdivisions n'est pas une puissance de 2.
+     */
+    static unsigned checkedShift(unsigned subdivisions);
+
+    /**
+     * Calcule les droites des morceaux, les enveloppes des cellules et les taux d'acceptation.
+     *
+     * @return Les probabilites de selection des cellules.
+     */
+    std::vector<double> computeEnvelopes();
+
+    /**
+     * Propose un point sous l'enveloppe d'une cellule et le soumet au test d'acceptation.
+     *
+     * @param cell L'indice de la cellule.
+     * @param U La position relative de X dans la cellule (U(0,1)).
+     * @param V La position relative de Y sous l'enveloppe (U(0,1)).
+     * @param X L'abscisse proposee.
+     * @return Si le point est accepte.
+     */
+    bool propose(uint64_t cell, double U, double V, double& X) const {
+        const Line& line = lines[cell >> shift];
+        double start = (double)(cell & ((uint64_t(1) << shift) - 1)) * line.cellWidth; // debut relatif de la cellule
+
+        // la fonction est monotone sur la cellule: ses bornes sont les valeurs aux extremites
+        double ya = line.slope * start + line.y0;
+        double yb = line.slope * line.cellWidth + ya;
+        double offset = U * line.cellWidth + start;
+        double Y = V * std::max(ya, yb);
+
+        X = line.x0 + offset;
+        return Y <= std::min(ya, yb) || Y <= line.slope * offset + line.y0;
+    }
 };
 
 
@@ -85,22 +323,32 @@ public:
  * Utilise la methode des melanges couplee a une approche geometrique afin de generer des realisation de
  * variables aleatoires.
  */
-class Geometric : public RandomValueGenerator {
+class Geometric final : public RandomValueGenerator {
 public:
     /**
      * Initialise les valeurs propres a cet algorithme.
      *
      * @param xs Les d'absisses des points constituant la fonction affine par morceaux.
      * @param ys Les ordonnees des points constituant la fonction affine par morceaux.
+     * @param method La methode de selection des tranches (voir PieceSelector).
      */
-    Geometric(const std::vector<double>& xs, const std::vector<double>& ys);
+    Geometric(const std::vector<double>& xs, const std::vector<double>& ys,
+              PieceSelector::Method method = PieceSelector::Method::AUTO);
+
+    using RandomValueGenerator::generate;
+    using RandomValueGenerator::generateBatch;
 
     /**
      * Genere une realisation d'une variable aleatoire associee a la fonction par morceaux.
      *
      * @return La variable aleatoire generee.
      */
-    double generate();
+    double generate(RandomEngine& engine) const;
+
+    /**
+     * @see RandomValueGenerator::generateBatch.
+     */
+    void generateBatch(RandomEngine& engine, double* out, size_t n) const;
 };
 
 
@@ -108,22 +356,129 @@ public:
  * Utilise la methode des melanges couplee a la methode des fonctions inverses afin de generer des realisation de
  * variables aleatoires.
  */
-class InverseFunctions : public RandomValueGenerator {
+class InverseFunctions final : public RandomValueGenerator {
+private:
+    /**
+     * Inversion exacte de la fonction de repartition sur un morceau, pour le mode table. Pour u dans le morceau et
+     * d = u - F, X = x0 + d * beta / (y0 + sqrt(y0Squared + hAlpha * d)): forme sans soustraction de deux racines
+     * voisines, valable aussi pour un morceau constant.
+     */
+    struct InverseCell {
+        double F;          // valeur de la fonction de repartition au debut du morceau
+        double x0, x1;     // bornes du morceau
+        double beta;       // largeur * (y0 + y1) / p_k
+        double y0;         // ordonnee au debut du morceau
+        double y0Squared;
+        double hAlpha;     // (y1 - y0) * (y0 + y1) / p_k
+    };
+
+    size_t resolution = 0;                  // nombre de cellules de la table (0: mode table desactive)
+    std::vector<InverseCell> cells;         // inversion de chaque morceau (mode table)
+    std::vector<uint64_t> table;            // table[j] = plus petit k tel que F_parts[k+1] > j / resolution
+    uint64_t lastPiece = 0;                 // dernier morceau de probabilite non nulle
+
 public:
     /**
      * Initialise les valeurs propres a cet algorithme.
      *
      * @param xs Les d'abscisses des points constituant la fonction affine par morceaux.
      * @param ys Les ordonnees des points constituant la fonction affine par morceaux.
+     * @param method La methode de selection des tranches (voir PieceSelector).
+     */
+    InverseFunctions(const std::vector<double>& xs, const std::vector<double>& ys,
+                     PieceSelector::Method method = PieceSelector::Method::AUTO);
+
+    using RandomValueGenerator::generate;
+    using RandomValueGenerator::generateBatch;
+
+    /**
+     * @see RandomValueGenerator::setPoints. La table est reconstruite si le mode table est active.
      */
-    InverseFunctions(const std::vector<double>& xs, const std::vector<double>& ys);
+    void setPoints(const std::vector<double>& xs, const std::vector<double>& ys);
+
+    /**
+     * Active le mode table: une table guide (Chen-Asau) de la fonction de repartition sur une grille de [0,1) donne
+     * directement le morceau de la plupart des uniformes, puis la fonction de repartition du morceau est inversee
+     * exactement. Une seule uniforme est utilisee par realisation (au lieu de deux), sans recherche dans la plupart
+     * des cas: la grille ne contient plusieurs morceaux que dans les cellules ou tombe une borne de morceau. Les
+     * realisations suivent exactement la meme loi, mais la suite obtenue pour une graine donnee change.
+     *
+     * La memoire utilisee est de 8 octets par cellule et 56 octets par morceau: une resolution de quelques fois le
+     * nombre de morceaux suffit a eviter presque toutes les recherches.
+     *
+     * @param resolution Le nombre de cellules de la grille, ou 0 pour revenir a la selection par PieceSelector.
+     */
+    void setTableResolution(size_t resolution);
+
+    /**
+     * @return Le nombre de cellules de la table (0 si le mode table n'est pas active).
+     */
+    size_t getTableResolution() const;
 
     /**
      * Genere une realisation d'une variable aleatoire associee a la fonction affine par morceaux.
      *
      * @return La variable aleatoire generee.
      */
-    double generate();
+    double generate(RandomEngine& engine) const;
+
+    /**
+     * @see RandomValueGenerator::generateBatch.
+     */
+    void generateBatch(RandomEngine& engine, double* out, size_t n) const;
+
+    /**
+     * Applique la fonction de repartition inverse F^-1 (exacte, croissante) a un point de [0,1). Contrairement a
+     * generate, une seule uniforme est utilisee: adaptee aux points quasi-aleatoires (voir ScrambledSobol). Utilise
+     * la table si le mode table est active.
+     *
+     * @param u Le point de [0,1).
+     * @return F^-1(u).
+     */
+    double inverse(double u) const;
+
+    /**
+     * Applique la fonction de repartition inverse a un lot de points.
+     *
+     * @param u Les points de [0,1).
+     * @param out Le tampon dans lequel ecrire les images.
+     * @param n Le nombre de points.
+     */
+    void inverseBatch(const double* u, double* out, size_t n) const;
+
+private:
+    /**
+     * Construit la table et les inversions des morceaux.
+     */
+    void buildTable();
+
+    /**
+     * @return L'indice du morceau contenant u (mode table): plus petit k tel que u < F_parts[k+1].
+     */
+    uint64_t tablePiece(double u) const {
+        size_t j = (size_t)(u * resolution);
+        if (j >= resolution) {
+            j = resolution - 1;
+        }
+
+        // recherche lineaire entre les morceaux indiques par la table (le plus souvent, aucun pas)
+        uint64_t k = table[j], end = table[j + 1];
+        while (k < end && u >= cells[k + 1].F) {
+            ++k;
+        }
+        return k;
+    }
+
+    /**
+     * @return F^-1(u) sur le morceau k (mode table).
+     */
+    double tableInverse(uint64_t k, double u) const {
+        const InverseCell& c = cells[k];
+        double d = std::max(u - c.F, 0.0);
+        double den = c.y0 + sqrt(c.y0Squared + c.hAlpha * d);
+        double X = den > 0 ? d * c.beta / den + c.x0 : c.x0;
+        return std::min(X, c.x1);
+    }
 };
 
 #endif // RANDOM_VALUE_GENERATOR_H
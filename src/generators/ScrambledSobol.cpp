@@ -0,0 +1,50 @@
+#include "ScrambledSobol.h"
+
+// 2^-53: conversion des 53 chiffres de poids fort en un double de [0,1)
+const double UNIT = 1.0 / 9007199254740992.0;
+
+ScrambledSobol::ScrambledSobol() : shift(0) {
+    for (unsigned k = 0; k < NUM_DIGITS; ++k) {
+        columns[k] = 1ULL << (NUM_DIGITS - 1 - k);
+    }
+}
+
+void ScrambledSobol::scramble(RandomEngine& engine) {
+    for (unsigned k = 0; k < NUM_DIGITS; ++k) {
+        // diagonale a 1, coefficients aleatoires pour les chiffres de poids plus faible
+        uint64_t diagonal = 1ULL << (NUM_DIGITS - 1 - k);
+        columns[k] = diagonal | (engine() & (diagonal - 1));
+    }
+    shift = engine();
+}
+
+uint64_t ScrambledSobol::digits(uint64_t i) const {
+    uint64_t gray = i ^ (i >> 1);
+    uint64_t y = shift;
+    for (unsigned k = 0; gray != 0; ++k, gray >>= 1) {
+        if (gray & 1) {
+            y ^= columns[k];
+        }
+    }
+    return y;
+}
+
+void ScrambledSobol::points(uint64_t first, double* out, size_t n) const {
+    if (n == 0) {
+        return;
+    }
+
+    uint64_t y = digits(first);
+    out[0] = (double)(y >> 11) * UNIT;
+
+    // d'un indice au suivant, le code de Gray ne change que d'un bit: celui de poids le plus faible de i
+    for (size_t j = 1; j < n; ++j) {
+        uint64_t i = first + j;
+        unsigned k = 0;
+        while (((i >> k) & 1) == 0) {
+            ++k;
+        }
+        y ^= columns[k];
+        out[j] = (double)(y >> 11) * UNIT;
+    }
+}
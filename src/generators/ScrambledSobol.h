@@ -0,0 +1,54 @@
+#ifndef SCRAMBLED_SOBOL_H
+#define SCRAMBLED_SOBOL_H
+
+#include <cstdint>
+#include <cstddef>
+
+#include "RandomEngine.h"
+
+/**
+ * Suite de Sobol a une dimension (suite de van der Corput en base 2) brouillee: brouillage lineaire de Matousek
+ * (matrice triangulaire inferieure aleatoire a diagonale unite) suivi d'un decalage digital aleatoire.
+ *
+ * Apres brouillage, chaque point suit une loi U(0,1) et les 2^m premiers points restent stratifies (un point par
+ * intervalle [j/2^m, (j+1)/2^m)): la moyenne sur les points est un estimateur sans biais dont la variance decroit
+ * plus vite qu'en 1/N pour une fonction reguliere. Les points sont parcourus dans l'ordre du code de Gray, ce qui
+ * donne les memes ensembles de 2^m premiers points.
+ */
+class ScrambledSobol {
+private:
+    static const unsigned NUM_DIGITS = 64;
+
+    uint64_t columns[NUM_DIGITS]; // colonne k: contribution du k-ieme bit de l'indice (chiffre de poids fort en tete)
+    uint64_t shift;               // decalage digital
+
+public:
+    /**
+     * Cree la suite non brouillee.
+     */
+    ScrambledSobol();
+
+    /**
+     * Tire un nouveau brouillage aleatoire.
+     *
+     * @param engine Le generateur a utiliser.
+     */
+    void scramble(RandomEngine& engine);
+
+    /**
+     * Calcule des points consecutifs de la suite.
+     *
+     * @param first L'indice du premier point.
+     * @param out Le tampon dans lequel ecrire les points (dans [0,1)).
+     * @param n Le nombre de points.
+     */
+    void points(uint64_t first, double* out, size_t n) const;
+
+private:
+    /**
+     * @return Les chiffres (brouilles) du point d'indice i dans l'ordre du code de Gray.
+     */
+    uint64_t digits(uint64_t i) const;
+};
+
+#endif // SCRAMBLED_SOBOL_H
@@ -0,0 +1,228 @@
+#include <stdexcept>
+#include <sstream>
+#include <fstream>
+#include <set>
+#include <type_traits>
+#include <algorithm>
+#include <cmath>
+
+#include "JobFile.h"
+#include "utility/Expression.h"
+
+std::string methodName(MethodKind method) {
+    switch (method) {
+        case MethodKind::UNIFORM: return "uniforme";
+        case MethodKind::IMPORTANCE: return "preferentiel";
+        case MethodKind::CONTROL_VARIABLE: return "controle";
+        case MethodKind::STRATIFIED: return "stratifie";
+    }
+    return "";
+}
+
+/**
+ * @return La chaine sans les espaces en debut et fin.
+ */
+static std::string trim(const std::string& s) {
+    size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+/**
+ * Lit une liste de valeurs separees par des espaces.
+ *
+ * @throw std::invalid_argument Si une valeur n'est pas valide.
+ */
+template <typename T>
+static std::vector<T> parseList(const std::string& value) {
+    std::istringstream iss(value);
+    std::vector<T> values;
+    std::string word;
+    while (iss >> word) {
+        // un entier non signe lirait "-5" comme 2^64 - 5
+        if (std::is_unsigned<T>::value && word[0] == '-') {
+            throw std::invalid_argument("valeur negative '" + word + "'");
+        }
+
+        std::istringstream item(word);
+        T t;
+        if (!(item >> t) || !item.eof()) {
+            throw std::invalid_argument("valeur invalide '" + word + "'");
+        }
+        values.push_back(t);
+    }
+    return values;
+}
+
+/**
+ * Verifie qu'une tache est complete.
+ *
+ * @throw std::invalid_argument Si une information manque.
+ */
+static void validate(const Job& job) {
+    if (job.integrand.empty()) {
+        throw std::invalid_argument("la tache '" + job.name + "' n'a pas de fonction");
+    }
+    if (!(job.a < job.b)) {
+        throw std::invalid_argument("la tache '" + job.name + "' n'a pas d'intervalle valide");
+    }
+    if (job.methods.empty()) {
+        throw std::invalid_argument("la tache '" + job.name + "' n'a pas de methode");
+    }
+    if (job.sizes.empty() && job.widths.empty() && job.times.empty()) {
+        throw std::invalid_argument("la tache '" + job.name + "' n'a ni taille, ni largeur, ni temps");
+    }
+
+    // la variable de controle genere d'abord l'echantillon pilote, qui fait partie de l'echantillon
+    bool control = std::find(job.methods.begin(), job.methods.end(), MethodKind::CONTROL_VARIABLE)
+                   != job.methods.end();
+    for (uint64_t size : job.sizes) {
+        if (control && size < job.pilotSize) {
+            throw std::invalid_argument("la tache '" + job.name + "' a une taille (" + std::to_string(size)
+                                        + ") plus petite que la taille pilote de la variable de controle ("
+                                        + std::to_string(job.pilotSize) + ")");
+        }
+    }
+}
+
+/**
+ * Affecte une valeur a une cle d'une tache.
+ *
+ * @throw std::invalid_argument Si la cle est inconnue ou la valeur invalide.
+ */
+static void assign(Job& job, const std::string& key, const std::string& value) {
+    if (key == "fonction") {
+        Expression check(value); // erreurs de syntaxe signalees a la lecture plutot qu'a l'execution
+        job.integrand = value;
+    } else if (key == "intervalle") {
+        std::vector<double> bounds = parseList<double>(value);
+        if (bounds.size() != 2) {
+            throw std::invalid_argument("l'intervalle doit etre donne par ses deux bornes");
+        }
+        job.a = bounds[0];
+        job.b = bounds[1];
+    } else if (key == "methodes") {
+        job.methods.clear();
+        for (const std::string& name : parseList<std::string>(value)) {
+            const MethodKind kinds[] = {MethodKind::UNIFORM, MethodKind::IMPORTANCE, MethodKind::CONTROL_VARIABLE,
+                                        MethodKind::STRATIFIED};
+            bool found = false;
+            for (MethodKind kind : kinds) {
+                if (name == methodName(kind)) {
+                    job.methods.push_back(kind);
+                    found = true;
+                }
+            }
+            if (!found) {
+                throw std::invalid_argument("methode inconnue '" + name + "'");
+            }
+        }
+    } else if (key == "points") {
+        std::vector<size_t> points = parseList<size_t>(value);
+        if (points.size() != 1 || points[0] < 2) {
+            throw std::invalid_argument("le nombre de points doit etre un entier d'au moins 2");
+        }
+        job.numPoints = points[0];
+    } else if (key == "graine") {
+        job.seed = parseList<uint32_t>(value);
+    } else if (key == "pilote") {
+        std::vector<uint64_t> sizes = parseList<uint64_t>(value);
+        if (sizes.size() != 1 || sizes[0] < 2) {
+            throw std::invalid_argument("la taille pilote doit etre un entier d'au moins 2");
+        }
+        job.pilotSize = sizes[0];
+    } else if (key == "tailles") {
+        job.sizes = parseList<uint64_t>(value);
+    } else if (key == "largeurs") {
+        job.widths = parseList<double>(value);
+        for (double width : job.widths) {
+            if (!(width > 0) || std::isinf(width)) {
+                throw std::invalid_argument("les largeurs doivent etre strictement positives");
+            }
+        }
+    } else if (key == "temps") {
+        job.times = parseList<double>(value);
+        for (double time : job.times) {
+            if (!(time >= 0) || std::isinf(time)) {
+                throw std::invalid_argument("les temps doivent etre positifs");
+            }
+        }
+    } else {
+        throw std::invalid_argument("cle inconnue '" + key + "'");
+    }
+}
+
+std::vector<Job> JobFile::read(std::istream& is) {
+    std::vector<Job> jobs;
+    std::set<std::string> names;
+    Job defaults;
+    Job* current = &defaults;
+    size_t jobLine = 0; // ligne du nom de la tache en cours (les erreurs de validation y sont rapportees)
+
+    // verifie la tache en cours, une fois toutes ses cles lues
+    auto validateCurrent = [&]() {
+        if (current == &defaults) {
+            return;
+        }
+        try {
+            validate(*current);
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument("Fichier de taches invalide (ligne " + std::to_string(jobLine) + "): "
+                                        + e.what());
+        }
+    };
+
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(is, line); ++lineNumber) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        // une nouvelle tache termine la precedente
+        if (line[0] == '[') {
+            validateCurrent();
+        }
+
+        try {
+            if (line[0] == '[') {
+                if (line.back() != ']' || trim(line.substr(1, line.size() - 2)).empty()) {
+                    throw std::invalid_argument("nom de tache invalide");
+                }
+
+                Job job = defaults;
+                job.name = trim(line.substr(1, line.size() - 2));
+                if (!names.insert(job.name).second) {
+                    throw std::invalid_argument("tache '" + job.name + "' deja definie");
+                }
+                jobs.push_back(job);
+                current = &jobs.back();
+                jobLine = lineNumber;
+                continue;
+            }
+
+            size_t equal = line.find('=');
+            if (equal == std::string::npos) {
+                throw std::invalid_argument("'cle = valeur' attendu");
+            }
+            assign(*current, trim(line.substr(0, equal)), trim(line.substr(equal + 1)));
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument("Fichier de taches invalide (ligne " + std::to_string(lineNumber) + "): "
+                                        + e.what());
+        }
+    }
+
+    validateCurrent();
+    return jobs;
+}
+
+std::vector<Job> JobFile::read(const std::string& path) {
+    std::ifstream ifs(path);
+    if (!ifs) {
+        throw std::runtime_error("Impossible d'ouvrir le fichier de taches '" + path + "'.");
+    }
+    return read(ifs);
+}
@@ -0,0 +1,77 @@
+#ifndef JOB_FILE_H
+#define JOB_FILE_H
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Methodes d'integration pouvant etre demandees par une tache.
+ */
+enum class MethodKind {
+    UNIFORM,            // echantillonnage uniforme (uniforme)
+    IMPORTANCE,         // echantillonnage preferentiel (preferentiel)
+    CONTROL_VARIABLE,   // echantillonnage uniforme avec variable de controle (controle)
+    STRATIFIED          // echantillonnage stratifie (stratifie)
+};
+
+/**
+ * @return Le nom de la methode dans un fichier de taches (ex: "uniforme").
+ */
+std::string methodName(MethodKind method);
+
+/**
+ * Une integrale a estimer et les echantillonnages a effectuer.
+ */
+struct Job {
+    std::string name;                     // nom de la tache (unique dans le fichier)
+    std::string integrand;                // fonction a integrer (voir Expression)
+    double a = 0, b = 0;                  // intervalle d'integration
+    std::vector<MethodKind> methods;      // methodes a utiliser
+    size_t numPoints = 15;                // nombre de points de la fonction affine par morceaux
+    std::vector<uint32_t> seed;           // parametres de la graine (vide: graine par defaut des methodes)
+    uint64_t pilotSize = 10000;           // taille de l'echantillon pilote de la variable de controle
+    std::vector<uint64_t> sizes;          // tailles d'echantillon (sampleWithSize)
+    std::vector<double> widths;           // largeurs max de l'IC (sampleWithMaxWidth)
+    std::vector<double> times;            // temps min [s] (sampleWithDeadline)
+};
+
+/**
+ * Lit un fichier de taches. Chaque tache commence par son nom entre crochets, suivi de lignes "cle = valeur":
+ *
+ *   [principale]
+ *   fonction = (25 + x*(x-6)*(x-8)*(x-14)/25) * exp(sqrt(1 + cos(x^2/10)))
+ *   intervalle = 0 15
+ *   methodes = uniforme preferentiel controle stratifie
+ *   points = 15
+ *   graine = 24 512 42
+ *   pilote = 10000
+ *   tailles = 100000 1000000
+ *   largeurs = 1 0.5 0.1
+ *   temps = 1 2
+ *
+ * Les cles placees avant la premiere tache donnent les valeurs par defaut des taches. Les lignes vides et celles
+ * commencant par # sont ignorees. Une tache doit avoir une fonction, un intervalle, au moins une methode et au moins
+ * une taille, largeur ou un temps. Les largeurs doivent etre strictement positives, les temps positifs et, si la tache
+ * utilise la variable de controle, les tailles au moins egales a la taille pilote.
+ */
+class JobFile {
+public:
+    /**
+     * @param is Le flux a lire.
+     * @return Les taches, dans l'ordre du fichier.
+     * @throw std::invalid_argument Si le fichier n'est pas valide (le message indique la ligne de l'erreur).
+     */
+    static std::vector<Job> read(std::istream& is);
+
+    /**
+     * @param path Le chemin du fichier.
+     * @throw std::runtime_error Si le fichier ne peut pas etre ouvert.
+     * @see read(std::istream&).
+     */
+    static std::vector<Job> read(const std::string& path);
+};
+
+#endif // JOB_FILE_H
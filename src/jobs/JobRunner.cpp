@@ -0,0 +1,136 @@
+#include <thread>
+#include <memory>
+#include <numeric>
+#include <algorithm>
+#include <sstream>
+
+#include "JobRunner.h"
+#include "montecarlo/UniformSampling.h"
+#include "montecarlo/ImportanceSampling.h"
+#include "montecarlo/ControlVariableMethod.h"
+#include "montecarlo/StratifiedSampling.h"
+#include "utility/Expression.h"
+
+JobRunner::JobRunner(unsigned numThreads)
+        : pool(numThreads > 0 ? numThreads : std::max(1u, std::thread::hardware_concurrency())) {}
+
+std::vector<JobResult> JobRunner::run(const std::vector<Job>& jobs) {
+    struct Unit {
+        size_t job;
+        MethodKind method;
+        double time; // temps minimum total de l'unite
+    };
+
+    std::vector<Unit> units;
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        double time = std::accumulate(jobs[j].times.begin(), jobs[j].times.end(), 0.0);
+        for (MethodKind method : jobs[j].methods) {
+            units.push_back({j, method, time});
+        }
+    }
+
+    // ordre de lancement: les unites les plus longues (temps minimum) d'abord; resultats dans l'ordre du fichier
+    std::vector<size_t> order(units.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&units](size_t i, size_t j) {
+        return units[i].time > units[j].time;
+    });
+
+    std::vector<std::unique_ptr<JobResult>> results(units.size());
+    pool.parallelFor(units.size(), [&](uint64_t i) {
+        const Unit& unit = units[order[i]];
+        results[order[i]].reset(new JobResult(runMethod(jobs[unit.job], unit.method)));
+    });
+
+    std::vector<JobResult> ordered;
+    ordered.reserve(results.size());
+    for (std::unique_ptr<JobResult>& result : results) {
+        ordered.push_back(std::move(*result));
+    }
+    return ordered;
+}
+
+JobResult JobRunner::runMethod(const Job& job, MethodKind method) {
+    JobResult result = {job.name, method, {}, std::string()};
+    try {
+        runSamplings(job, method, result);
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    return result;
+}
+
+void JobRunner::runSamplings(const Job& job, MethodKind method, JobResult& result) {
+    Expression g(job.integrand);
+
+    std::unique_ptr<MonteCarloMethod> m;
+    switch (method) {
+        case MethodKind::UNIFORM:
+            m.reset(new UniformSampling(g, job.a, job.b));
+            break;
+        case MethodKind::IMPORTANCE: {
+            Points points = Stats::createPoints(job.numPoints, g, job.a, job.b);
+            m.reset(new ImportanceSampling(g, points.xs, points.ys));
+            break;
+        }
+        case MethodKind::CONTROL_VARIABLE: {
+            Points points = Stats::createPoints(job.numPoints, g, job.a, job.b);
+            ControlVariable* cv = new ControlVariable(g, job.a, job.b, points.xs, points.ys);
+            m.reset(cv);
+            cv->setSamplingSize(job.pilotSize);
+            break;
+        }
+        case MethodKind::STRATIFIED: {
+            Points points = Stats::createPoints(job.numPoints, g, job.a, job.b);
+            m.reset(new StratifiedSampling(g, points.xs));
+            break;
+        }
+    }
+
+    if (!job.seed.empty()) {
+        std::seed_seq seed(job.seed.begin(), job.seed.end());
+        m->setSeed(seed);
+    }
+
+    for (uint64_t size : job.sizes) {
+        result.samplings.push_back({StoppingRule::SIZE, (double)size, m->sampleWithSize(size)});
+    }
+    for (double width : job.widths) {
+        result.samplings.push_back({StoppingRule::MAX_WIDTH, width, m->sampleWithMaxWidth(width)});
+    }
+    for (double time : job.times) {
+        result.samplings.push_back({StoppingRule::DEADLINE, time, m->sampleWithDeadline(time)});
+    }
+}
+
+std::string JobRunner::ruleName(StoppingRule rule) {
+    switch (rule) {
+        case StoppingRule::SIZE: return "Taille";
+        case StoppingRule::MAX_WIDTH: return "Largeur max IC";
+        case StoppingRule::DEADLINE: return "Temps min [s]";
+    }
+    return "";
+}
+
+std::string JobRunner::constraintString(const JobSampling& sampling) {
+    std::ostringstream oss;
+    if (sampling.rule == StoppingRule::SIZE) {
+        oss << (uint64_t)sampling.constraint;
+    } else {
+        oss << sampling.constraint;
+    }
+    return oss.str();
+}
+
+void JobRunner::write(ResultsWriter& writer, const std::vector<JobResult>& results) {
+    for (const JobResult& result : results) {
+        for (size_t i = 0; i < result.samplings.size(); ++i) {
+            const JobSampling& sampling = result.samplings[i];
+
+            if (i == 0 || result.samplings[i - 1].rule != sampling.rule) {
+                writer.writeHeader(result.job + "/" + methodName(result.method) + " - " + ruleName(sampling.rule));
+            }
+            writer.write(sampling.constraint, sampling.sampling);
+        }
+    }
+}
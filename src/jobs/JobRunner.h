@@ -0,0 +1,103 @@
+#ifndef JOB_RUNNER_H
+#define JOB_RUNNER_H
+
+#include <string>
+#include <vector>
+
+#include "JobFile.h"
+#include "ResultsWriter.h"
+#include "montecarlo/MonteCarloMethod.h"
+#include "utility/ThreadPool.h"
+
+/**
+ * Critere d'arret d'un echantillonnage.
+ */
+enum class StoppingRule {
+    SIZE,        // taille d'echantillon (sampleWithSize)
+    MAX_WIDTH,   // largeur max de l'IC (sampleWithMaxWidth)
+    DEADLINE     // temps min (sampleWithDeadline)
+};
+
+/**
+ * Un echantillonnage effectue pour une tache.
+ */
+struct JobSampling {
+    StoppingRule rule;
+    double constraint;                   // taille, largeur max ou temps min demande
+    MonteCarloMethod::Sampling sampling;
+};
+
+/**
+ * Resultats d'une methode pour une tache: les echantillonnages dans l'ordre des tailles, puis des largeurs et des
+ * temps (la methode continue ses flux aleatoires de l'un a l'autre, comme dans main.cpp).
+ */
+struct JobResult {
+    std::string job;
+    MethodKind method;
+    std::vector<JobSampling> samplings;
+    std::string error;                   // erreur ayant interrompu la methode (vide: aucune), apres ses samplings
+};
+
+/**
+ * Execute les taches d'un fichier de taches en parallele.
+ *
+ * Chaque couple (tache, methode) est une unite de travail executee en mode sequentiel par un thread du pool: les
+ * threads prennent la prochaine unite des qu'ils sont libres, de sorte qu'un grand nombre de petites integrales occupe
+ * tous les coeurs. Les unites avec un temps minimum sont lancees en premier (les plus longues d'abord) afin de ne pas
+ * finir par une longue unite isolee. Les resultats ne dependent pas de l'ordre d'execution (sauf pour les criteres en
+ * temps).
+ */
+class JobRunner {
+private:
+    ThreadPool pool;
+
+public:
+    /**
+     * @param numThreads Le nombre de threads (par defaut, le nombre de coeurs de la machine).
+     */
+    explicit JobRunner(unsigned numThreads = 0);
+
+    /**
+     * Execute les taches.
+     *
+     * @param jobs Les taches.
+     * @return Les resultats, dans l'ordre des taches puis de leurs methodes. Une erreur (ex: fonction non definie
+     * sur l'intervalle) n'interrompt que son unite: elle est rapportee dans le resultat de l'unite (voir
+     * JobResult::error), qui garde les echantillonnages deja termines.
+     */
+    std::vector<JobResult> run(const std::vector<Job>& jobs);
+
+    /**
+     * Ecrit les resultats: pour chaque critere d'une methode d'une tache, une section ("tache/methode - critere")
+     * contenant une ligne par echantillonnage.
+     *
+     * @param writer Le fichier de resultats.
+     * @param results Les resultats.
+     */
+    static void write(ResultsWriter& writer, const std::vector<JobResult>& results);
+
+    /**
+     * @return Le libelle d'un critere d'arret (premiere colonne de l'en-tete CSV).
+     */
+    static std::string ruleName(StoppingRule rule);
+
+    /**
+     * @return La contrainte d'un echantillonnage sous forme de texte (premiere colonne des lignes CSV).
+     */
+    static std::string constraintString(const JobSampling& sampling);
+
+private:
+    /**
+     * Execute une methode d'une tache. Les erreurs sont rapportees dans le resultat (voir run).
+     */
+    static JobResult runMethod(const Job& job, MethodKind method);
+
+    /**
+     * Effectue les echantillonnages d'une methode d'une tache, en les ajoutant au resultat au fur et a mesure.
+     *
+     * @throw std::exception Si la methode ne peut pas etre creee ou si un echantillonnage echoue.
+     */
+    static void runSamplings(const Job& job, MethodKind method, JobResult& result);
+};
+
+#endif // JOB_RUNNER_H
@@ -0,0 +1,262 @@
+#include <stdexcept>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "ResultsWriter.h"
+
+const std::string ResultsWriter::CSV_HEADER =
+        "N generations;Aire estimee;IC;RC(N) * ET;largeur IC;Temps [s];IC inf;IC sup";
+
+static const char MAGIC[8] = {'S', 'I', 'O', 'M', 'C', 'R', 'E', 'S'};
+static const uint32_t VERSION = 1;
+static const size_t NUM_COLUMNS = 8;
+
+/**
+ * Ajoute la representation binaire d'une valeur a un tampon.
+ */
+template <typename T>
+static void append(std::string& buffer, const T& value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * Lit une valeur binaire.
+ *
+ * @throw std::runtime_error Si le fichier est tronque.
+ */
+template <typename T>
+static T readValue(std::istream& is) {
+    T value;
+    if (!is.read(reinterpret_cast<char*>(&value), sizeof(value))) {
+        throw std::runtime_error("Fichier de resultats tronque.");
+    }
+    return value;
+}
+
+ResultsWriter::ResultsWriter(const std::string& path, Format format, bool append) : format(format) {
+    bool empty = true;
+    if (append) {
+        std::ifstream existing(path, std::ios_base::binary | std::ios_base::ate);
+        empty = !existing || existing.tellg() <= 0;
+    }
+
+    out.open(path, std::ios_base::binary | (append ? std::ios_base::app : std::ios_base::trunc));
+    if (!out) {
+        throw std::runtime_error("Impossible d'ouvrir le fichier de resultats '" + path + "'.");
+    }
+
+    if (format == Format::BINARY && empty) {
+        out.write(MAGIC, sizeof(MAGIC));
+        out.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+    }
+
+    worker = std::thread(&ResultsWriter::work, this);
+}
+
+ResultsWriter::~ResultsWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    pending.notify_one();
+    worker.join();
+}
+
+void ResultsWriter::writeHeader(const std::string& label) {
+    enqueue({true, label, 0, MonteCarloMethod::Sampling{0, 0, ConfidenceInterval(0, 0), 0, 0, 0}});
+}
+
+void ResultsWriter::write(const MonteCarloMethod::Sampling& s) {
+    enqueue({false, std::string(), std::numeric_limits<double>::quiet_NaN(), s});
+}
+
+void ResultsWriter::write(double constraint, const MonteCarloMethod::Sampling& s) {
+    enqueue({false, std::string(), constraint, s});
+}
+
+void ResultsWriter::enqueue(Item item) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(item));
+        ++queued;
+    }
+    pending.notify_one();
+}
+
+void ResultsWriter::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    uint64_t target = queued;
+    flushTarget = std::max(flushTarget, target);
+    pending.notify_one();
+    written.wait(lock, [this, target] { return flushed >= target; });
+}
+
+void ResultsWriter::work() {
+    std::vector<Item> items;
+
+    while (true) {
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            pending.wait(lock, [this] { return stopping || !queue.empty() || flushed < flushTarget; });
+            items.swap(queue);
+            stop = stopping;
+        }
+
+        // formatage et ecriture hors du verrou: les threads appelants peuvent continuer a ajouter des lignes
+        if (format == Format::CSV) {
+            writeCsv(items);
+        } else {
+            writeBinary(items);
+        }
+
+        // un flush demande apres cette decision est traite au tour suivant (flushed < flushTarget)
+        bool flush;
+        uint64_t count;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done += items.size();
+            count = done;
+            flush = stop || flushed < flushTarget;
+        }
+        if (flush) {
+            out.flush();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (flush) {
+                flushed = count;
+            }
+            if (stop && queue.empty()) {
+                written.notify_all();
+                return;
+            }
+        }
+        written.notify_all();
+        items.clear();
+    }
+}
+
+void ResultsWriter::writeCsv(const std::vector<Item>& items) {
+    std::ostringstream oss;
+
+    for (const Item& item : items) {
+        if (item.header) {
+            if (!item.label.empty()) {
+                oss << item.label << CSV_SEPARATOR;
+            }
+            oss << CSV_HEADER << '\n';
+            continue;
+        }
+
+        const MonteCarloMethod::Sampling& s = item.sampling;
+        if (!std::isnan(item.constraint)) {
+            oss.unsetf(std::ios_base::floatfield);
+            oss << std::setprecision(15) << item.constraint << CSV_SEPARATOR;
+        }
+        oss << s.N << CSV_SEPARATOR;
+        oss << std::fixed;
+        oss << std::setprecision(5) << s.areaEstimator << CSV_SEPARATOR;
+        oss << s.confidenceInterval << CSV_SEPARATOR;
+        oss << (std::sqrt(s.N) * s.stdDevEstimator) << CSV_SEPARATOR;
+        oss << s.confidenceInterval.width << CSV_SEPARATOR;
+        oss << std::setprecision(3) << s.elapsedTime << CSV_SEPARATOR;
+        oss << s.confidenceInterval.lower << CSV_SEPARATOR;
+        oss << s.confidenceInterval.upper << CSV_SEPARATOR;
+        oss << '\n';
+    }
+
+    out << oss.str();
+}
+
+void ResultsWriter::writeBinary(const std::vector<Item>& items) {
+    std::string buffer;
+
+    for (size_t i = 0; i < items.size();) {
+        if (items[i].header) {
+            buffer += 'S';
+            append(buffer, (uint32_t)items[i].label.size());
+            buffer += items[i].label;
+            ++i;
+            continue;
+        }
+
+        // paquet des lignes consecutives, colonne par colonne
+        size_t end = i;
+        while (end < items.size() && !items[end].header) {
+            ++end;
+        }
+
+        buffer += 'R';
+        append(buffer, (uint32_t)(end - i));
+        for (size_t j = i; j < end; ++j) append(buffer, items[j].constraint);
+        for (size_t j = i; j < end; ++j) append(buffer, items[j].sampling.N);
+        for (size_t j = i; j < end; ++j) append(buffer, items[j].sampling.areaEstimator);
+        for (size_t j = i; j < end; ++j) append(buffer, items[j].sampling.stdDevEstimator);
+        for (size_t j = i; j < end; ++j) append(buffer, items[j].sampling.confidenceInterval.lower);
+        for (size_t j = i; j < end; ++j) append(buffer, items[j].sampling.confidenceInterval.upper);
+        for (size_t j = i; j < end; ++j) append(buffer, items[j].sampling.elapsedTime);
+        for (size_t j = i; j < end; ++j) append(buffer, items[j].sampling.numEvaluations);
+
+        i = end;
+    }
+
+    out.write(buffer.data(), buffer.size());
+}
+
+std::vector<ResultsRow> ResultsWriter::readBinary(const std::string& path) {
+    std::ifstream is(path, std::ios_base::binary);
+    if (!is) {
+        throw std::runtime_error("Impossible d'ouvrir le fichier de resultats '" + path + "'.");
+    }
+
+    char magic[sizeof(MAGIC)];
+    if (!is.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0
+        || readValue<uint32_t>(is) != VERSION) {
+        throw std::runtime_error("'" + path + "' n'est pas un fichier de resultats binaire.");
+    }
+
+    std::vector<ResultsRow> rows;
+    std::string section;
+    char tag;
+    while (is.get(tag)) {
+        uint32_t n = readValue<uint32_t>(is);
+
+        if (tag == 'S') {
+            section.resize(n);
+            if (!is.read(&section[0], n)) {
+                throw std::runtime_error("Fichier de resultats tronque.");
+            }
+        } else if (tag == 'R') {
+            // colonnes lues telles quelles (8 octets par valeur), puis reinterpretees
+            std::vector<uint64_t> columns(NUM_COLUMNS * n);
+            if (!is.read(reinterpret_cast<char*>(columns.data()), columns.size() * sizeof(uint64_t))) {
+                throw std::runtime_error("Fichier de resultats tronque.");
+            }
+            auto real = [&columns, n](size_t column, size_t j) {
+                double d;
+                std::memcpy(&d, &columns[column * n + j], sizeof(d));
+                return d;
+            };
+
+            for (size_t j = 0; j < n; ++j) {
+                double area = real(2, j), lower = real(4, j), upper = real(5, j);
+                ConfidenceInterval ci(area, 0);
+                ci.lower = lower;
+                ci.upper = upper;
+                ci.width = upper - lower;
+
+                rows.push_back({section, real(0, j),
+                                {area, real(3, j), ci, columns[n + j], real(6, j), columns[7 * n + j]}});
+            }
+        } else {
+            throw std::runtime_error("Enregistrement inconnu dans le fichier de resultats.");
+        }
+    }
+    return rows;
+}
@@ -0,0 +1,144 @@
+#ifndef RESULTS_WRITER_H
+#define RESULTS_WRITER_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "montecarlo/MonteCarloMethod.h"
+
+/**
+ * Une ligne de resultats relue depuis un fichier binaire (voir ResultsWriter::readBinary).
+ */
+struct ResultsRow {
+    std::string section;                 // en-tete de la section contenant la ligne
+    double constraint;                   // contrainte de l'echantillonnage (NaN si la ligne n'en a pas)
+    MonteCarloMethod::Sampling sampling;
+};
+
+/**
+ * Ecrit des echantillonnages dans un fichier, en arriere-plan: le fichier reste ouvert, les lignes sont mises en
+ * attente par les threads appelants (sans formatage ni entree-sortie) et un thread dedie les formate et les ecrit par
+ * paquets.
+ *
+ * Deux formats sont disponibles:
+ * - CSV: une ligne d'en-tete par section ("libelle;N generations;..."), puis une ligne par echantillonnage
+ *   ("contrainte;N;aire;IC;..."), comme les fichiers de main.cpp;
+ * - binaire, en colonnes: apres l'en-tete du fichier ("SIOMCRES" et la version, sur 4 octets), une suite
+ *   d'enregistrements: section ('S', longueur du libelle sur 4 octets, libelle) ou paquet de lignes ('R', nombre de
+ *   lignes n sur 4 octets, puis 8 colonnes de n valeurs de 8 octets: contrainte, N, aire, ecart-type, borne inferieure
+ *   et superieure de l'IC, temps, nombre d'evaluations). Les nombres sont dans l'ordre des octets de la machine et les
+ *   valeurs sont exactes (64 octets par ligne). Voir readBinary.
+ */
+class ResultsWriter {
+public:
+    enum class Format {
+        CSV,
+        BINARY
+    };
+
+    static const char CSV_SEPARATOR = ';';
+    static const std::string CSV_HEADER;
+
+private:
+    /**
+     * Element en attente d'ecriture: debut de section ou ligne.
+     */
+    struct Item {
+        bool header;                          // debut de section (label) ou ligne (constraint et sampling)
+        std::string label;
+        double constraint;
+        MonteCarloMethod::Sampling sampling;
+    };
+
+    Format format;
+    std::ofstream out;
+
+    std::mutex mutex;
+    std::condition_variable pending;   // reveille le thread d'ecriture
+    std::condition_variable written;   // signale que les elements en attente ont ete ecrits
+    std::vector<Item> queue;           // elements en attente
+    uint64_t queued = 0;               // nombre d'elements mis en attente depuis la creation
+    uint64_t done = 0;                 // nombre d'elements ecrits
+    uint64_t flushed = 0;              // nombre d'elements ecrits et transmis au systeme (out.flush)
+    uint64_t flushTarget = 0;          // plus grand nombre d'elements a transmettre demande par flush
+    bool stopping = false;
+    std::thread worker;
+
+public:
+    /**
+     * Ouvre le fichier et lance le thread d'ecriture.
+     *
+     * @param path Le chemin du fichier.
+     * @param format Le format du fichier.
+     * @param append Ajoute les resultats a la fin du fichier (qui doit etre au meme format) au lieu de l'ecraser.
+     * @throw std::runtime_error Si le fichier ne peut pas etre ouvert.
+     */
+    explicit ResultsWriter(const std::string& path, Format format = Format::CSV, bool append = false);
+
+    /**
+     * Ecrit les elements en attente et ferme le fichier.
+     */
+    ~ResultsWriter();
+
+    ResultsWriter(const ResultsWriter&) = delete;
+    ResultsWriter& operator=(const ResultsWriter&) = delete;
+
+    /**
+     * Commence une section.
+     *
+     * @param label Le libelle de la section (premiere colonne de l'en-tete CSV; vide pour n'ecrire que CSV_HEADER).
+     */
+    void writeHeader(const std::string& label);
+
+    /**
+     * Ajoute une ligne sans contrainte.
+     */
+    void write(const MonteCarloMethod::Sampling& s);
+
+    /**
+     * Ajoute une ligne.
+     *
+     * @param constraint La contrainte de l'echantillonnage (ex: taille, largeur max de l'IC ou temps min).
+     * @param s L'echantillonnage.
+     */
+    void write(double constraint, const MonteCarloMethod::Sampling& s);
+
+    /**
+     * Attend que les elements en attente lors de l'appel soient ecrits dans le fichier. Les elements ajoutes ensuite
+     * par d'autres threads ne prolongent pas l'attente.
+     */
+    void flush();
+
+    /**
+     * Lit un fichier au format binaire.
+     *
+     * @param path Le chemin du fichier.
+     * @return Les lignes du fichier.
+     * @throw std::runtime_error Si le fichier ne peut pas etre ouvert ou n'est pas valide.
+     */
+    static std::vector<ResultsRow> readBinary(const std::string& path);
+
+private:
+    /**
+     * Met un element en attente.
+     */
+    void enqueue(Item item);
+
+    /**
+     * Boucle du thread d'ecriture.
+     */
+    void work();
+
+    /**
+     * Formate et ecrit des elements.
+     */
+    void writeCsv(const std::vector<Item>& items);
+    void writeBinary(const std::vector<Item>& items);
+};
+
+#endif // RESULTS_WRITER_H
@@ -4,42 +4,43 @@
 #include <iostream>
 #include <iomanip>
 #include <list>
-#include <fstream>
 #include <cstdint>
+#include <memory>
 
 #include "montecarlo/UniformSampling.h"
 #include "montecarlo/ImportanceSampling.h"
 #include "montecarlo/ControlVariableMethod.h"
+#include "montecarlo/StratifiedSampling.h"
+#include "utility/FastMath.h"
+#include "utility/Expression.h"
+#include "utility/Profiler.h"
+#include "jobs/JobRunner.h"
 
 using namespace std;
 
 #define EXPORT_CSV true
+#define EXPORT_TELEMETRY true
+
+// nombre de threads utilises par les methodes (0: mode sequentiel)
+const unsigned NUM_THREADS = 0;
+// nombre de processus de calcul entre lesquels les echantillonnages sont repartis (0: pas de mode reparti)
+const unsigned NUM_PROCESSES = 0;
 const string CSV_FILE = "results.csv";
 const string TESTS_CSV_FILE = "tests.csv";
-const char CSV_SEPARATOR = ';';
-const string CSV_HEADER = "N generations;Aire estimee;IC;RC(N) * ET;largeur IC;Temps [s];IC inf;IC sup";
+const string BINARY_FILE = "results.bin";
+
+// compteurs des echantillonnages en cours, exportes periodiquement au format de Prometheus (voir Telemetry)
+const string TELEMETRY_FILE = "telemetry.prom";
+const double TELEMETRY_PERIOD = 5;
+
+// fichiers de resultats (ouverts par main si EXPORT_CSV est active), ecrits en arriere-plan
+unique_ptr<ResultsWriter> testsWriter, resultsWriter;
 
 const string MAX_WIDTH = "Largeur max IC";
 const string MIN_TIME = "Temps min [s]";
 const string HEADER = "N generations | Aire estimee |      IC a 95%      | RC(N) * ET | largeur IC | Temps [s]";
 
 
-/**
- * Exporte l'echantillon en CSV.
- */
-void exportSampling(ofstream& ofs, const MonteCarloMethod::Sampling& s) {
-    ofs << s.N << CSV_SEPARATOR;
-    ofs << fixed;
-    ofs << setprecision(5) << s.areaEstimator << CSV_SEPARATOR;
-    ofs << s.confidenceInterval << CSV_SEPARATOR;
-    ofs << (sqrt(s.N) * s.stdDevEstimator) << CSV_SEPARATOR;
-    ofs << s.confidenceInterval.width << CSV_SEPARATOR;
-    ofs << setprecision(3) << s.elapsedTime << CSV_SEPARATOR;
-    ofs << s.confidenceInterval.lower << CSV_SEPARATOR;
-    ofs << s.confidenceInterval.upper << CSV_SEPARATOR;
-    ofs << endl;
-}
-
 /**
  * Affiche l'echantilon.
  */
@@ -55,16 +56,32 @@ void printSampling(const MonteCarloMethod::Sampling& s) {
     cout << endl;
 }
 
+/**
+ * Remet a zero les mesures par phase, si le profilage est active a la compilation (voir Profiler).
+ */
+void startProfile() {
+#ifdef SIO_PROFILE
+    Profiler::reset();
+#endif
+}
+
+/**
+ * Affiche la repartition du temps par phase depuis startProfile, si le profilage est active a la compilation.
+ */
+void printProfile() {
+#ifdef SIO_PROFILE
+    Profiler::print(cout, Profiler::breakdown());
+#endif
+}
+
 /**
  * Affiche l'echantillon et l'exporte en CSV si l'option est activee.
  */
 void printExportSampling(const MonteCarloMethod::Sampling& s) {
     printSampling(s);
 
-    if (EXPORT_CSV) {
-        ofstream ofs(TESTS_CSV_FILE, ios_base::app);
-        exportSampling(ofs, s);
-        ofs.close();
+    if (testsWriter) {
+        testsWriter->write(s);
     }
 }
 
@@ -75,11 +92,8 @@ void printExportSampling(double constraint, const MonteCarloMethod::Sampling& s)
     cout << setw(14) << constraint << " | ";
     printSampling(s);
 
-    if (EXPORT_CSV) {
-        ofstream ofs(CSV_FILE, ios_base::app);
-        ofs << constraint << CSV_SEPARATOR;
-        exportSampling(ofs, s);
-        ofs.close();
+    if (resultsWriter) {
+        resultsWriter->write(constraint, s);
     }
 }
 
@@ -90,14 +104,15 @@ void printExportSampling(double constraint, const MonteCarloMethod::Sampling& s)
  */
 void runImplementationTest(MonteCarloMethod& m) {
     cout << HEADER << endl;
-    if (EXPORT_CSV) {
-        ofstream ofs(TESTS_CSV_FILE, ios_base::app);
-        ofs << CSV_HEADER << endl;
-        ofs.close();
+    if (testsWriter) {
+        testsWriter->writeHeader("");
     }
 
     for (uint64_t i = 100000; i <= 10000000; i *= 10) {
-        printExportSampling(m.sampleWithSize(i));
+        startProfile();
+        MonteCarloMethod::Sampling s = m.sampleWithSize(i);
+        printExportSampling(s);
+        printProfile();
     }
     cout << endl;
 }
@@ -109,47 +124,133 @@ void runImplementationTest(MonteCarloMethod& m) {
  *
  * Les resultats sont affiches et egalement exportes en CSV si l'option est activee.
  */
-void runTests(MonteCarloMethod& m, const list<double>& maxWidths, const list<double>& minTimes, uint64_t step) {
+void runTests(MonteCarloMethod& m, const list<double>& maxWidths, const list<double>& minTimes) {
 
     cout << MAX_WIDTH << " | " << HEADER << endl;
-    if (EXPORT_CSV) {
-        ofstream ofs(CSV_FILE, ios_base::app);
-        ofs << MAX_WIDTH << CSV_SEPARATOR << CSV_HEADER << endl;
-        ofs.close();
+    if (resultsWriter) {
+        resultsWriter->writeHeader(MAX_WIDTH);
     }
     for (double maxWidth: maxWidths) {
-        printExportSampling(maxWidth, m.sampleWithMaxWidth(maxWidth, step));
+        startProfile();
+        MonteCarloMethod::Sampling s = m.sampleWithMaxWidth(maxWidth);
+        printExportSampling(maxWidth, s);
+        printProfile();
     }
     cout << endl;
 
     cout << MIN_TIME << "  | " << HEADER << endl;
-    if (EXPORT_CSV) {
-        ofstream ofs(CSV_FILE, ios_base::app);
-        ofs << MIN_TIME << CSV_SEPARATOR << CSV_HEADER << endl;
-        ofs.close();
+    if (resultsWriter) {
+        resultsWriter->writeHeader(MIN_TIME);
     }
     for (double minTime: minTimes) {
-        printExportSampling(minTime, m.sampleWithMinTime(minTime, step));
+        startProfile();
+        MonteCarloMethod::Sampling s = m.sampleWithDeadline(minTime);
+        printExportSampling(minTime, s);
+        printProfile();
     }
     cout << endl;
 }
 
-int main () {
+/**
+ * Execute les taches d'un fichier de taches (voir JobFile) en parallele.
+ *
+ * Les resultats sont affiches et egalement exportes en CSV si l'option est activee.
+ *
+ * @param path Le chemin du fichier de taches.
+ * @param numThreads Le nombre de threads (0: nombre de coeurs de la machine).
+ * @param binary Ecrit les resultats au format binaire (voir ResultsWriter) plutot qu'en CSV.
+ */
+int runJobs(const string& path, unsigned numThreads, bool binary) {
+    vector<JobResult> results;
+    try {
+        vector<Job> jobs = JobFile::read(path);
+        JobRunner runner(numThreads);
+        results = runner.run(jobs);
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_SUCCESS;
+    for (const JobResult& result : results) {
+        for (size_t i = 0; i < result.samplings.size(); ++i) {
+            const JobSampling& sampling = result.samplings[i];
+            if (i == 0 || result.samplings[i - 1].rule != sampling.rule) {
+                cout << endl << "-- " << result.job << " / " << methodName(result.method) << " --" << endl;
+                cout << setw(14) << JobRunner::ruleName(sampling.rule) << " | " << HEADER << endl;
+            }
+            cout << setw(14) << JobRunner::constraintString(sampling) << " | ";
+            printSampling(sampling.sampling);
+        }
+
+        // une unite en erreur n'empeche pas d'ecrire les resultats des autres
+        if (!result.error.empty()) {
+            cerr << result.job << " / " << methodName(result.method) << ": " << result.error << endl;
+            status = EXIT_FAILURE;
+        }
+    }
+
+    if (EXPORT_CSV) {
+        ResultsWriter writer(binary ? BINARY_FILE : CSV_FILE,
+                             binary ? ResultsWriter::Format::BINARY : ResultsWriter::Format::CSV);
+        JobRunner::write(writer, results);
+    }
+    return status;
+}
+
+int main (int argc, char* argv[]) {
+
+    // taches lues dans un fichier (ex: SIO_MonteCarlo --jobs taches.txt [nombre de threads] [--binary])
+    if (argc >= 3 && string(argv[1]) == "--jobs") {
+        unsigned numThreads = 0;
+        bool binary = false;
+        for (int i = 3; i < argc; ++i) {
+            if (string(argv[i]) == "--binary") {
+                binary = true;
+            } else {
+                numThreads = (unsigned)stoul(argv[i]);
+            }
+        }
+        return runJobs(argv[2], numThreads, binary);
+    }
 
     // fonction dont on veut estimer l'aire
     MonteCarloMethod::Func g = [](double x) {
         return (25 + x * (x - 6) * (x - 8) * (x - 14) / 25) * exp(sqrt(1 + cos(x*x / 10)));
     };
 
+    // meme fonction, evaluee par lots (vectorisee) par les methodes
+    MonteCarloMethod::BatchFunc gBatch = [](const double* xs, double* ys, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            double x = xs[i];
+            ys[i] = (25 + x * (x - 6) * (x - 8) * (x - 14) / 25)
+                    * FastMath::exp(FastMath::sqrt(1 + FastMath::cos(x*x / 10)));
+        }
+    };
+
     // borne inferieure et superieure
     double a = 0, b = 15;
 
+    // fonction et intervalle donnes en parametres (ex: SIO_MonteCarlo "x^2 * exp(-x)" 0 10), sans recompiler
+    if (argc == 4) {
+        try {
+            Expression expression(argv[1]);
+            g = expression;
+            gBatch = expression;
+            a = stod(argv[2]);
+            b = stod(argv[3]);
+        } catch (const exception& e) {
+            cerr << e.what() << endl;
+            return EXIT_FAILURE;
+        }
+    } else if (argc != 1) {
+        cerr << "Usage: " << argv[0] << " [expression a b | --jobs fichier [threads] [--binary]]" << endl;
+        return EXIT_FAILURE;
+    }
+
     // creation des points de la fonction affine par morceaux
     Points points = Stats::createPoints(15, g, a, b);
 
-    // nombre d'etapes a faire dans le cas de generations avec une largeur d'IC ou un temps limite
-    uint64_t step = 100000;
-
     // graine utilisee pour les generateurs
     seed_seq seed = {24, 512, 42};
 
@@ -171,21 +272,31 @@ int main () {
 
     if (EXPORT_CSV) {
         // cree un nouveau fichier / ecrase l'ancien s'il existe
-        ofstream ofs(TESTS_CSV_FILE);
-        ofs.close();
+        testsWriter.reset(new ResultsWriter(TESTS_CSV_FILE));
     }
 
     cout << "-----------------------------------------------------" << endl;
     cout << "| Test de l'implementation des differentes methodes |" << endl;
     cout << "-----------------------------------------------------" << endl << endl;
     {
-        UniformSampling us(g, a, b);
-        ImportanceSampling is(g, points.xs, points.ys);
-        ControlVariable cv(g, a, b, points.xs, points.ys);
+        UniformSampling us(gBatch, a, b);
+        ImportanceSampling is(gBatch, points.xs, points.ys);
+        ControlVariable cv(gBatch, a, b, points.xs, points.ys);
+        StratifiedSampling ss(gBatch, points.xs);
 
         us.setSeed(seed);
         is.setSeed(seed);
         cv.setSeed(seed);
+        ss.setSeed(seed);
+
+        us.setNumThreads(NUM_THREADS);
+        us.setNumProcesses(NUM_PROCESSES);
+        is.setNumThreads(NUM_THREADS);
+        is.setNumProcesses(NUM_PROCESSES);
+        cv.setNumThreads(NUM_THREADS);
+        cv.setNumProcesses(NUM_PROCESSES);
+        ss.setNumThreads(NUM_THREADS);
+        ss.setNumProcesses(NUM_PROCESSES);
 
         const uint64_t M = 10000;
         cv.setSamplingSize(M);
@@ -198,43 +309,72 @@ int main () {
 
         cout << "-- Echantillonage uniforme avec variable de controle --" << endl;
         runImplementationTest(cv);
+
+        cout << "-- Echantillonage stratifie --" << endl;
+        runImplementationTest(ss);
     }
 
     if (EXPORT_CSV) {
         // cree un nouveau fichier / ecrase l'ancien s'il existe
-        ofstream ofs(CSV_FILE);
-        ofs.close();
+        resultsWriter.reset(new ResultsWriter(CSV_FILE));
     }
 
     cout << "---------------------------------------------------------------------" << endl;
     cout << "| Echantillonages en utillisant differentes methodes et contraintes |" << endl;
     cout << "---------------------------------------------------------------------" << endl << endl;
 
+    // les echantillonnages les plus longs (jusqu'a 1024 s) sont suivis en direct
+    Telemetry telemetry;
+    if (EXPORT_TELEMETRY) {
+        telemetry.startReporting(TELEMETRY_PERIOD, nullptr, TELEMETRY_FILE);
+    }
+
     {
-        UniformSampling us(g, a, b);
+        UniformSampling us(gBatch, a, b);
         us.setSeed(seed);
+        us.setNumThreads(NUM_THREADS);
+        us.setNumProcesses(NUM_PROCESSES);
+        us.setTelemetry(&telemetry);
         cout << "-- Echantillonage uniforme --" << endl;
-        runTests(us, maxWidths, minTimes, step);
+        runTests(us, maxWidths, minTimes);
     }
 
     {
-        ImportanceSampling is(g, points.xs, points.ys);
+        ImportanceSampling is(gBatch, points.xs, points.ys);
         is.setSeed(seed);
+        is.setNumThreads(NUM_THREADS);
+        is.setNumProcesses(NUM_PROCESSES);
+        is.setTelemetry(&telemetry);
 
         cout << "-- Echantillonage preferentiel --" << endl;
-        runTests(is, maxWidths, minTimes, step);
+        runTests(is, maxWidths, minTimes);
     }
 
     {
-        ControlVariable cv(g, a, b, points.xs, points.ys);
+        ControlVariable cv(gBatch, a, b, points.xs, points.ys);
         cv.setSeed(seed);
+        cv.setNumThreads(NUM_THREADS);
+        cv.setNumProcesses(NUM_PROCESSES);
+        cv.setTelemetry(&telemetry);
 
         uint64_t M = 10000;
         cv.setSamplingSize(M);
 
         cout << "-- Echantillonage uniforme avec variable de controle --" << endl;
         cout << "Avec M = " << M << " :" << endl;
-        runTests(cv, maxWidths, minTimes, step);
+        runTests(cv, maxWidths, minTimes);
+    }
+
+    {
+        // une strate par morceau de la fonction affine par morceaux
+        StratifiedSampling ss(gBatch, points.xs);
+        ss.setSeed(seed);
+        ss.setNumThreads(NUM_THREADS);
+        ss.setNumProcesses(NUM_PROCESSES);
+        ss.setTelemetry(&telemetry);
+
+        cout << "-- Echantillonage stratifie --" << endl;
+        runTests(ss, maxWidths, minTimes);
     }
 
 
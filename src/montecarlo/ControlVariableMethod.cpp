@@ -1,144 +1,300 @@
-#include <ctime>
+#include <stdexcept>
+#include <algorithm>
 
 #include "ControlVariableMethod.h"
+#include "../utility/Profiler.h"
+
+/**
+ * @return Un tableau d'au moins size valeurs propre au thread appelant, reutilise d'un bloc a l'autre (les valeurs des
+ * variables de controle d'un lot: pas d'allocation par bloc).
+ */
+static double* controlScratch(size_t size) {
+    static thread_local std::vector<double> buffer;
+    if (buffer.size() < size) {
+        buffer.resize(size);
+    }
+    return buffer.data();
+}
 
+/**
+ * @return Un tableau d'au moins size pointeurs propre au thread appelant (les colonnes d'un lot de vecteurs (Y, Z)).
+ */
+static const double** columnScratch(size_t size) {
+    static thread_local std::vector<const double*> buffer;
+    if (buffer.size() < size) {
+        buffer.resize(size);
+    }
+    return buffer.data();
+}
 
 ControlVariable::ControlVariable(const Func& g, double a, double b,
                                  const std::vector<double>& xs, const std::vector<double>& ys)
-        :
-        MonteCarloMethod(g), a(a), b(b),
-        uniformDistr(std::uniform_real_distribution<double>(0, 1)),
-        h(xs, ys)
+        : ControlVariable(makeIntegrand(g), a, b, xs, ys) {}
+
+ControlVariable::ControlVariable(std::unique_ptr<const Integrand> g, double a, double b,
+                                 const std::vector<double>& xs, const std::vector<double>& ys)
+        : ControlVariable(std::move(g), a, b)
+{
+    addControl(xs, ys);
+}
+
+ControlVariable::ControlVariable(const Func& g, double a, double b) : ControlVariable(makeIntegrand(g), a, b) {}
 
+ControlVariable::ControlVariable(std::unique_ptr<const Integrand> g, double a, double b)
+        : MonteCarloMethod(std::move(g)), a(a), b(b)
 {
     if (a >= b) {
         throw std::invalid_argument("Borne inferieure plus grande ou egale a la borne superieure.");
     }
-    mu = h.A / (b-a);
+}
+
+void ControlVariable::addControl(const std::vector<double>& xs, const std::vector<double>& ys) {
+    PiecewiseLinearFunction h(xs, ys);
+    double mu = h.A / (b-a);
+    addControl(makeIntegrand(std::move(h)), mu);
+}
+
+void ControlVariable::addControl(const Func& h, double mu) {
+    addControl(makeIntegrand(h), mu);
+}
+
+void ControlVariable::addControl(std::unique_ptr<const Integrand> h, double mu) {
+    controls.push_back(std::move(h));
+    mus.push_back(mu);
+    c.assign(controls.size(), 0);
 }
 
 void ControlVariable::setSamplingSize(uint64_t M) {
     this->M = M;
 }
 
-MonteCarloMethod::Sampling ControlVariable::sampleWithSize(uint64_t N) {
-
-    // phase 1 : calcul de la constante 'c'
-    computeConstant();
+void ControlVariable::setRunningConstant(bool enabled) {
+    runningConstant = enabled;
+}
 
+MonteCarloMethod::Sampling ControlVariable::sampleWithSize(uint64_t N) {
     if (N < M) {
         throw std::invalid_argument("N est plus petit que M");
     }
 
-    uint64_t step = N - M;
-    numGen = M;
-
-    // phase 2 : on poursuit l'echantillonage jusqu'a la taille de N desiree
-    sample(step);
-    return createSampling((double)(clock() - start) / CLOCKS_PER_SEC);
+    // phase 1 : calcul de la constante 'c', phase 2 : on poursuit l'echantillonage jusqu'a la taille de N desiree
+    return MonteCarloMethod::sampleWithSize(N);
 }
 
-MonteCarloMethod::Sampling ControlVariable::sampleWithMaxWidth(double maxWidth, uint64_t step) {
-
+void ControlVariable::prepare() {
     // phase 1 : calcul de la constante 'c'
     computeConstant();
-
     numGen = M;
+}
 
-    // phase 2 : on poursuit l'echantillonage jusqu'a la largeur de l'IC desiree
-    do {
-        sample(step);
-    } while (halfWidth * 2 > maxWidth);
+void ControlVariable::computeConstant() {
 
-    return createSampling((double)(clock() - start) / CLOCKS_PER_SEC);
-}
+    init();
 
-MonteCarloMethod::Sampling ControlVariable::sampleWithMinTime(double minTime, uint64_t step) {
+    covariance = CovarianceAccumulator(controls.size() + 1);
+    accumulateCovariance(M);
+    updateConstant();
 
-    // phase 1 : calcul de la constante 'c'
-    computeConstant();
+    // les valeurs V de la phase preliminaire font partie de l'echantillon
+    values = regressionValues();
+}
 
-    numGen = M;
-    double curTime = 0;
+void ControlVariable::sample(uint64_t step) {
+    if (!runningConstant) {
+        MonteCarloMethod::sample(step);
+        return;
+    }
 
-    // phase 2 : on poursuit l'echantillonage jusqu'a atteindre le temps minimal desire
-    do {
-        clock_t beg = clock();
-        sample(step);
-        curTime += (double)(clock() - beg) / CLOCKS_PER_SEC;
-    } while (curTime < minTime);
+    // les coefficients, recalcules sur tout l'echantillon, s'appliquent a toutes les valeurs
+    accumulateCovariance(step);
+    updateConstant();
+    values = regressionValues();
 
-    return createSampling(curTime);
+    numGen += step;
+    updateStatistics();
 }
 
-void ControlVariable::setSeed(const std::seed_seq &seed) {
-    std::seed_seq copy = seed;
-    mtGenerator.seed(copy);
+void ControlVariable::saveState(StateWriter& out) const {
+    if (!runningConstant) {
+        MonteCarloMethod::saveState(out);
+        return;
+    }
+
+    out.writeCovariance(covariance);
 }
 
-void ControlVariable::computeConstant() {
+void ControlVariable::mergeStates(const std::vector<std::string>& states) {
+    if (!runningConstant) {
+        MonteCarloMethod::mergeStates(states);
+        return;
+    }
 
-    init();
+    // co-moments de tous les processus, puis estimateur par regression sur l'echantillon complet
+    covariance = CovarianceAccumulator(controls.size() + 1);
+    for (const std::string& state : states) {
+        StateReader in(state);
+        CovarianceAccumulator other = in.readCovariance();
+        if (other.dimension() != controls.size() + 1 || !in.atEnd()) {
+            throw std::runtime_error("Etat d'echantillonnage incompatible.");
+        }
+        covariance.merge(other);
+    }
 
-    std::vector<double> yks, zks;
-    yks.reserve(M), zks.reserve(M);
+    updateConstant();
+    values = regressionValues();
+    numGen = covariance.count();
+    updateStatistics();
+}
 
-    for (uint64_t i = 0; i < M; ++i) {
-        double X = uniformDistr(mtGenerator) * (b-a) + a; // X ~ U(a,b)
-        yks.push_back(g(X));
-        zks.push_back(h(X));
-    }
+void ControlVariable::accumulateCovariance(uint64_t n) {
+    std::vector<CovarianceAccumulator> partials(numBlocks(n), CovarianceAccumulator(controls.size() + 1));
 
-    double varZ = 0, meanY = 0;
-    for (uint64_t i = 0; i < M; ++i) {
-        double tmp = zks[i] - mu;
-        varZ += tmp * tmp;
-        meanY += yks[i];
+    runBlocks(n, [&](uint64_t i, RandomEngine& engine, uint64_t size) {
+        sampleCovariance(engine, size, partials[i]);
+    });
+
+    // fusion dans l'ordre des blocs: le resultat est independant de l'ordre d'execution
+    for (const CovarianceAccumulator& p : partials) {
+        covariance.merge(p);
     }
+}
 
-    varZ /= M;
-    meanY /= M;
+void ControlVariable::sampleCovariance(RandomEngine& engine, uint64_t n, CovarianceAccumulator& acc) const {
+    size_t k = controls.size();
 
-    double covYZ = 0;
-    for (uint64_t i = 0; i < M; ++i) {
-        covYZ += (yks[i] - meanY) * (zks[i] - mu);
-    }
+    double xs[2 * BATCH_SIZE], ys[2 * BATCH_SIZE];
+    double* zs = controlScratch(2 * BATCH_SIZE * k);
+    const double** columns = columnScratch(k + 1);
 
-    covYZ /= M;
+    for (uint64_t done = 0; done < n; done += BATCH_SIZE) {
+        size_t m = (size_t)std::min<uint64_t>(BATCH_SIZE, n - done);
+        size_t numPoints = antithetic ? 2 * m : m;
 
-    c = -(covYZ / varZ);
+        SIO_PROFILE_BATCH(m);
+        generatePoints(engine, xs, m);
+        evaluatePoints(xs, ys, zs, m);
 
-    for (uint64_t i = 0; i < M; ++i) {
-        double V = yks[i] + c * (zks[i] - mu);
-        sum += V;
-        sumSquares += V * V;
+        columns[0] = ys;
+        for (size_t j = 0; j < k; ++j) {
+            columns[j + 1] = zs + j * numPoints;
+        }
+        acc.add(columns, m);
+        SIO_PROFILE_MARK(ACCUMULATE);
     }
 }
 
-void ControlVariable::sample(uint64_t step) {
+void ControlVariable::updateConstant() {
+    size_t k = controls.size();
+    c.assign(k, 0);
+    if (covariance.count() < 2) {
+        return;
+    }
 
-    for (uint64_t i = 0; i < step; ++i) {
-        double X = uniformDistr(mtGenerator) * (b - a) + a; // X ~ U(a,b)
-        double Y = g(X), Z = h(X);
-        double V = Y + c * (Z - mu);
-        sum += V;
-        sumSquares += V * V;
+    // matrice de covariance des Z_j et covariances entre les Z_j et Y
+    std::vector<double> covZ(k * k), covYZ(k);
+    for (size_t j = 0; j < k; ++j) {
+        for (size_t l = 0; l < k; ++l) {
+            covZ[j * k + l] = covariance.covariance(j + 1, l + 1);
+        }
+        covYZ[j] = covariance.covariance(0, j + 1);
     }
 
-    numGen += step;
+    c = Stats::solve(covZ, covYZ);
+    for (double& cj : c) {
+        cj = -cj;
+    }
+}
 
-    mean = sum / numGen;
-    double var = (sumSquares / numGen) - mean * mean;
-    stdDev = (b-a) * sqrt(var / numGen);
-    halfWidth = 1.96 * stdDev;
+Accumulator ControlVariable::regressionValues() const {
+    size_t k = controls.size();
+
+    // V = Y + somme des c_j (Z_j - mu_j) est lineaire en (Y, Z): ses moments se deduisent de ceux de (Y, Z)
+    double meanV = covariance.mean(0);
+    double m2V = covariance.comoment(0, 0);
+    for (size_t j = 0; j < k; ++j) {
+        meanV += c[j] * (covariance.mean(j + 1) - mus[j]);
+        m2V += 2 * c[j] * covariance.comoment(0, j + 1);
+        for (size_t l = 0; l < k; ++l) {
+            m2V += c[j] * c[l] * covariance.comoment(j + 1, l + 1);
+        }
+    }
+
+    return Accumulator(covariance.count(), meanV, std::max(m2V, 0.0));
 }
 
-MonteCarloMethod::Sampling ControlVariable::createSampling(double timeElapsed) const {
-    double areaEstimator = (b-a) * mean;
-    return {areaEstimator, stdDev, ConfidenceInterval(areaEstimator, halfWidth), numGen, timeElapsed};
+void ControlVariable::sampleBlock(RandomEngine& engine, uint64_t n, Accumulator& acc) const {
+    size_t k = controls.size();
+
+    double xs[2 * BATCH_SIZE], ys[2 * BATCH_SIZE];
+    double* zs = controlScratch(2 * BATCH_SIZE * k);
+
+    for (uint64_t done = 0; done < n; done += BATCH_SIZE) {
+        size_t m = (size_t)std::min<uint64_t>(BATCH_SIZE, n - done);
+        size_t numPoints = antithetic ? 2 * m : m;
+        SIO_PROFILE_BATCH(m);
+
+        generatePoints(engine, xs, m);
+        evaluatePoints(xs, ys, zs, m);
+
+        // une seule passe sur le lot: toutes les variables de controle sont appliquees a chaque valeur
+        for (size_t i = 0; i < m; ++i) {
+            double V = ys[i];
+            for (size_t j = 0; j < k; ++j) {
+                V += c[j] * (zs[j * numPoints + i] - mus[j]);
+            }
+            ys[i] = V; // V = Y + somme des c_j(Z_j - mu_j)
+        }
+
+        acc.add(ys, m);
+        SIO_PROFILE_MARK(ACCUMULATE);
+    }
 }
 
+void ControlVariable::generatePoints(RandomEngine& engine, double* xs, size_t m) const {
+    fillUniform(engine, xs, m);
+    SIO_PROFILE_MARK(UNIFORM);
+    for (size_t i = 0; i < m; ++i) {
+        xs[i] = xs[i] * (b - a) + a; // X ~ U(a,b)
+    }
 
+    // en mode antithetique, les points a + b - X suivent les X
+    if (antithetic) {
+        for (size_t i = 0; i < m; ++i) {
+            xs[m + i] = a + b - xs[i];
+        }
+    }
+    SIO_PROFILE_MARK(TRANSFORM);
+}
 
+void ControlVariable::evaluatePoints(const double* xs, double* ys, double* zs, size_t m) const {
+    size_t numPoints = antithetic ? 2 * m : m;
+    size_t k = controls.size();
+
+    g->evaluate(xs, ys, numPoints);
+    SIO_PROFILE_MARK(INTEGRAND);
+    for (size_t j = 0; j < k; ++j) {
+        controls[j]->evaluate(xs, zs + j * numPoints, numPoints);
+    }
+    SIO_PROFILE_MARK(FIND_PIECE);
+
+    // en mode antithetique, Y et Z sont les moyennes des valeurs en X et en a + b - X
+    if (antithetic) {
+        for (size_t i = 0; i < m; ++i) {
+            ys[i] = (ys[i] + ys[m + i]) / 2;
+        }
+        for (size_t j = 0; j < k; ++j) {
+            double* zj = zs + j * numPoints;
+            for (size_t i = 0; i < m; ++i) {
+                zj[i] = (zj[i] + zj[m + i]) / 2;
+            }
+        }
+    }
+}
 
+double ControlVariable::scale() const {
+    return b - a;
+}
 
+bool ControlVariable::supportsAntithetic() const {
+    return true;
+}
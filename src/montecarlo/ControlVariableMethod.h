@@ -2,23 +2,31 @@
 #define CONTROL_VARIABLE_H
 
 #include "MonteCarloMethod.h"
+#include "../utility/CovarianceAccumulator.h"
 
 /**
- * Represente la methode d'integration par echantillonnage uniforme avec variable de controle.
+ * Represente la methode d'integration par echantillonnage uniforme avec variables de controle.
+ *
+ * Plusieurs variables de controle Z_j = h_j(X) peuvent etre utilisees (voir addControl), chacune etant une fonction
+ * affine par morceaux ou une fonction dont l'esperance mu_j sur [a,b] est connue. Le vecteur des coefficients
+ * c = -Cov(Z)^-1 Cov(Z, Y) est calcule lors de la phase preliminaire, et V = Y + somme des c_j (Z_j - mu_j).
+ *
+ * La phase preliminaire ne conserve pas les valeurs generees: elle accumule en une passe les moyennes et les
+ * co-moments de (Y, Z_1, ..., Z_k) (voir CovarianceAccumulator), en parallele en mode parallele. La memoire utilisee
+ * ne depend donc pas de M, et les valeurs V de la phase preliminaire sont deduites de ces moments.
  */
 class ControlVariable : public MonteCarloMethod {
 private:
-    // generateur mersenne-twister et distribution uniforme
-    std::mt19937_64 mtGenerator;
-    std::uniform_real_distribution<double> uniformDistr;
-
-    PiecewiseLinearFunction h; // variable de controle (fonction affine par morceaux)
+    std::vector<std::unique_ptr<const Integrand>> controls; // fonctions h_j des variables de controle
 
     double a, b; // bornes inferieure et superieure de l'intervalle sur lequel on veut evaluer la fonction
-    double mu;   // esperance de la fonction par morceaux
+    std::vector<double> mus; // esperances mu_j des variables de controle
+
+    std::vector<double> c; // coefficients c_j tq V = Y + somme des c_j (Z_j - mu_j), avec Y = g(X)
+    uint64_t M = 0; // taille de l'echantillon pour determiner 'c' (nombre de paires en mode antithetique)
 
-    double c;     // coefficient c tq V = Y + c(Z - mu), avec Y = g(X) et Z(X) la variable de controle
-    uint64_t M = 0; // taille de l'echantillon pour determiner 'c'
+    bool runningConstant = false;      // si 'c' est mis a jour a chaque etape (voir setRunningConstant)
+    CovarianceAccumulator covariance;  // moments de (Y, Z_1, ..., Z_k) (phase preliminaire, ou tout l'echantillon)
 
 public:
     /**
@@ -33,10 +41,86 @@ public:
     ControlVariable(const Func& g, double a, double b, const std::vector<double>& xs, const std::vector<double>& ys);
 
     /**
-     * Fixe la valeur de
+     * Prepare la methode avec une fonction dont le type est connu a la compilation (ex: lambda): les appels a g dans
+     * la boucle d'echantillonnage sont alors mis en ligne. Une fonction de signature
+     * void(const double*, double*, size_t) (voir BatchFunc) est evaluee directement sur les lots de points generes.
+     *
+     * @see ControlVariable(const Func&, double, double, const std::vector<double>&, const std::vector<double>&).
+     */
+    template <typename G>
+    ControlVariable(G g, double a, double b, const std::vector<double>& xs, const std::vector<double>& ys)
+            : ControlVariable(makeIntegrand(std::move(g)), a, b, xs, ys) {}
+
+    /**
+     * @see ControlVariable(const Func&, double, double, const std::vector<double>&, const std::vector<double>&).
+     */
+    ControlVariable(std::unique_ptr<const Integrand> g, double a, double b,
+                    const std::vector<double>& xs, const std::vector<double>& ys);
+
+    /**
+     * Prepare la methode sans variable de controle (voir addControl).
+     *
+     * @param g La fonction dont on veut estimer l'aire.
+     * @param a la borne inferieure de l'intervalle sur lequel on veut evaluer g.
+     * @param b la borne superieure de l'intervalle sur lequel on veut evaluer g.
+     */
+    ControlVariable(const Func& g, double a, double b);
+
+    /**
+     * @see ControlVariable(const Func&, double, double).
+     */
+    template <typename G>
+    ControlVariable(G g, double a, double b) : ControlVariable(makeIntegrand(std::move(g)), a, b) {}
+
+    /**
+     * @see ControlVariable(const Func&, double, double).
+     */
+    ControlVariable(std::unique_ptr<const Integrand> g, double a, double b);
+
+    /**
+     * Ajoute une variable de controle sous forme de fonction affine par morceaux (son esperance est calculee).
+     *
+     * @param xs Les abscisses des points de la variable de controle.
+     * @param ys Les ordonnees des points de la variable de controle.
+     */
+    void addControl(const std::vector<double>& xs, const std::vector<double>& ys);
+
+    /**
+     * Ajoute une variable de controle dont l'esperance est connue.
+     *
+     * @param h La fonction de la variable de controle.
+     * @param mu L'esperance de h(X), avec X ~ U(a,b) (l'integrale de h sur [a,b] divisee par b - a).
+     */
+    void addControl(const Func& h, double mu);
+
+    /**
+     * @see addControl(const Func&, double).
+     */
+    template <typename H>
+    void addControl(H h, double mu) {
+        addControl(makeIntegrand(std::move(h)), mu);
+    }
+
+    /**
+     * @see addControl(const Func&, double).
+     */
+    void addControl(std::unique_ptr<const Integrand> h, double mu);
+
+    /**
+     * Fixe la taille de l'echantillon utilise pour determiner les coefficients 'c'.
      */
     void setSamplingSize(uint64_t M);
 
+    /**
+     * Active la mise a jour continue des coefficients 'c': apres chaque etape, ils sont recalcules a partir des
+     * co-moments de tout l'echantillon, et appliques a toutes les valeurs (estimateur par regression). Aucune phase
+     * preliminaire separee n'est alors necessaire (M peut valoir 0). Les coefficients etant estimes sur les valeurs
+     * de l'echantillon, l'estimateur a un biais en O(1/N), negligeable devant l'ecart-type.
+     *
+     * @param enabled Si le mode doit etre active.
+     */
+    void setRunningConstant(bool enabled);
+
 
     /**
      * @see MontecarloMethod::sampleWithSize.
@@ -44,46 +128,104 @@ public:
      * Utilisable uniquement apres que 'setSamplingSize' ait ete appelee au moins une fois apres la creation de l'objet.
      */
     Sampling sampleWithSize(uint64_t N);
+
+protected:
     /**
-     * @see MontecarloMethod::sampleWithMaxWidth.
+     * Calcule les coefficients 'c' (phase 1). Les valeurs generees pour ce calcul font partie de l'echantillon.
      *
-     * Utilisable uniquement apres que 'setSamplingSize' ait ete appelee au moins une fois apres la creation de l'objet.
+     * Doit etre appelee avant d'utiliser les methodes d'echantillonnage (voir MontecarloMethod::sampleWithMaxWidth et
+     * MontecarloMethod::sampleWithMinTime).
+     */
+    void prepare();
+
+    /**
+     * @see MonteCarloMethod::sample.
      */
-    Sampling sampleWithMaxWidth(double maxWidth, uint64_t step);
+    void sample(uint64_t step);
+
+    /**
+     * @see MonteCarloMethod::saveState. Avec la mise a jour continue des coefficients, l'etat contient les co-moments
+     * de (Y, Z_1, ..., Z_k): le coordinateur calcule les coefficients sur l'echantillon complet.
+     */
+    void saveState(StateWriter& out) const;
+
     /**
-     * @see MontecarloMethod::sampleWithMinTime.
+     * @see MonteCarloMethod::mergeStates. Sans mise a jour continue, chaque processus utilise les coefficients de sa
+     * propre phase preliminaire: les valeurs V restent d'esperance egale a l'aire et sont fusionnees telles quelles.
+     */
+    void mergeStates(const std::vector<std::string>& states);
+
+    /**
+     * @see MonteCarloMethod::sampleBlock.
      *
-     * Utilisable uniquement apres que 'setSamplingSize' ait ete appelee au moins une fois apres la creation de l'objet.
+     * Utilisable uniquement apres un appel a 'prepare'.
      */
-    Sampling sampleWithMinTime(double maxTime, uint64_t step);
+    void sampleBlock(RandomEngine& engine, uint64_t n, Accumulator& acc) const;
 
     /**
-     * @see MonteCarloMethod::setSeed.
+     * @see MonteCarloMethod::scale.
      */
-    void setSeed(const std::seed_seq& seed);
+    double scale() const;
+
+    /**
+     * @see MonteCarloMethod::supportsAntithetic.
+     */
+    bool supportsAntithetic() const;
 
 private:
     /**
-     * Calcule la constante 'c'.
+     * Calcule les coefficients 'c'.
      */
     void computeConstant();
 
-    /*
-     * Effectue un certain nombre donne de generations afin de mettre a jour les statistiques (somme, somme des
-     * carres, moyenne, etc) afin de creer un IC pour l'aire estimee.
+    /**
+     * Genere des valeurs et ajoute les vecteurs (Y, Z_1, ..., Z_k) obtenus aux co-moments, en parallele en mode
+     * parallele.
      *
-     * Utilisable uniquement apres un appel a 'computeConstant'.
+     * @param n Le nombre de valeurs a generer.
+     */
+    void accumulateCovariance(uint64_t n);
+
+    /**
+     * Effectue un certain nombre de generations avec un generateur donne et ajoute les vecteurs (Y, Z_1, ..., Z_k)
+     * obtenus a un accumulateur donne.
      *
-     * @param step Le nombre de generation qui seront effectuees.
+     * @param engine Le generateur a utiliser.
+     * @param n Le nombre de generations a effectuer.
+     * @param acc L'accumulateur a mettre a jour.
      */
-    void sample(uint64_t step);
+    void sampleCovariance(RandomEngine& engine, uint64_t n, CovarianceAccumulator& acc) const;
+
+    /**
+     * Calcule les coefficients 'c' a partir des co-moments.
+     */
+    void updateConstant();
+
+    /**
+     * @return Le resume (nombre, moyenne, somme des carres des ecarts) des valeurs V associees aux co-moments, avec
+     * les coefficients 'c' actuels.
+     */
+    Accumulator regressionValues() const;
+
+    /**
+     * Genere un lot de points X ~ U(a,b) (suivis en mode antithetique des points a + b - X).
+     *
+     * @param engine Le generateur a utiliser.
+     * @param xs Le tampon des abscisses (2m valeurs en mode antithetique).
+     * @param m Le nombre de points X.
+     */
+    void generatePoints(RandomEngine& engine, double* xs, size_t m) const;
 
     /**
-     * Empaquete toutes les valeurs associees a l'echantillon (aire estimee, IC, etc: voir MonteCarloMethod::Sampling).
+     * Evalue g et les variables de controle sur un lot de points. En mode antithetique, les m points a + b - X
+     * doivent suivre les m points X, et les m premieres valeurs de chaque tampon recoivent les moyennes des paires.
      *
-     * @return L'echantillon cree.
+     * @param xs Les abscisses (m, ou 2m en mode antithetique).
+     * @param ys Le tampon des valeurs de Y (meme taille que xs).
+     * @param zs Le tampon des valeurs des Z_j, une colonne de la taille de xs par variable de controle.
+     * @param m Le nombre de valeurs.
      */
-    Sampling createSampling(double timeElapsed) const;
+    void evaluatePoints(const double* xs, double* ys, double* zs, size_t m) const;
 };
 
 #endif // CONTROL_VARIABLE_H
@@ -1,67 +1,360 @@
-#include <ctime>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
 
 #include "ImportanceSampling.h"
+#include "../utility/Profiler.h"
 
-ImportanceSampling::ImportanceSampling(const std::function<double(double)>& g, const std::vector<double>& xs, const std::vector<double>& ys)
-        : MonteCarloMethod(g), generator(xs, ys) {}
+// mode adaptatif: nombre de valeurs par tache (et par flux), amortissement du deplacement des points (exposant de
+// VEGAS) et ordonnee minimale de la densite, relative a la plus grande (f doit rester positive ou g est non nulle)
+static const uint64_t ADAPTIVE_TASK_SIZE = 1 << 14;
+static const double DAMPING = 1.5;
+static const double MIN_RELATIVE_DENSITY = 0.01;
 
-MonteCarloMethod::Sampling ImportanceSampling::sampleWithSize(uint64_t N) {
-    init();
-    sample(N);
-    return {mean, stdDev, ConfidenceInterval(mean, halfWidth), N, (double)(clock() - start) / CLOCKS_PER_SEC};
+ImportanceSampling::ImportanceSampling(const Func& g, const std::vector<double>& xs, const std::vector<double>& ys)
+        : ImportanceSampling(makeIntegrand(g), xs, ys) {}
+
+ImportanceSampling::ImportanceSampling(std::unique_ptr<const Integrand> g, const std::vector<double>& xs,
+                                       const std::vector<double>& ys)
+        : MonteCarloMethod(std::move(g)), generator(xs, ys), initialXs(xs), initialYs(ys) {}
+
+void ImportanceSampling::setSeed(const std::seed_seq& seed) {
+    MonteCarloMethod::setSeed(seed);
+    nextStream = 0;
+}
+
+void ImportanceSampling::setAdaptive(uint64_t size) {
+    if (size > 0 && isQuasiRandom()) {
+        throw std::invalid_argument("Le mode adaptatif n'est pas disponible en mode quasi-Monte Carlo.");
+    }
+    iterationSize = size;
 }
 
-MonteCarloMethod::Sampling ImportanceSampling::sampleWithMaxWidth(double maxWidth, uint64_t step) {
+void ImportanceSampling::prepare() {
     init();
 
-    // genere des valeurs tant que la largeur de l'intervalle de confiance est plus grande que "maxWidth"
-    do {
-        sample(step);
-    } while (halfWidth * 2 > maxWidth);
+    if (iterationSize > 0) {
+        generator.setPoints(initialXs, initialYs);
+        bestXs = initialXs;
+        bestYs = initialYs;
+        bestVariance = std::numeric_limits<double>::infinity();
+        frozen = false;
 
-    return {mean, stdDev, ConfidenceInterval(mean, halfWidth), numGen, (double)(clock() - start) / CLOCKS_PER_SEC};
+        iteration = Accumulator();
+        pieceSums.assign(generator.getPWLFunc().size(), PieceSums());
+        sumInvVar = 0;
+        sumWeightedAreas = 0;
+        sumCounts = 0;
+    }
 }
 
-MonteCarloMethod::Sampling ImportanceSampling::sampleWithMinTime(double maxTime, uint64_t step) {
-    init();
+void ImportanceSampling::sample(uint64_t step) {
+    if (iterationSize == 0) {
+        MonteCarloMethod::sample(step);
+        return;
+    }
+
+    // l'etape est decoupee aux fins d'iterations, ou la densite est affinee
+    for (uint64_t done = 0; done < step;) {
+        uint64_t n = std::min(step - done, iterationSize - iteration.count());
+        sampleIteration(n);
+        done += n;
 
-    double curTime = 0;
+        if (iteration.count() == iterationSize) {
+            endIteration();
+        }
+    }
+
+    numGen += step;
+    updateAdaptiveStatistics();
+}
+
+void ImportanceSampling::sampleBlock(RandomEngine& engine, uint64_t n, Accumulator& acc) const {
+    const PiecewiseLinearFunction& f = generator.getPWLFunc();
+    double xs[BATCH_SIZE], gs[BATCH_SIZE], fs[BATCH_SIZE];
 
-    // genere des valeurs tant que le temps maximal d'execution n'est pas atteint
-    do {
-        clock_t beg = clock();
-        sample(step);
-        curTime += (double)(clock() - beg) / CLOCKS_PER_SEC;
-    } while (curTime < maxTime);
+    // les valeurs sont generees par lots (appel non virtuel: InverseFunctions est finale)
+    for (uint64_t done = 0; done < n; done += BATCH_SIZE) {
+        size_t m = (size_t)std::min<uint64_t>(BATCH_SIZE, n - done);
+        SIO_PROFILE_BATCH(m);
+        generator.generateBatch(engine, xs, m);
+        g->evaluate(xs, gs, m);
+        SIO_PROFILE_MARK(INTEGRAND);
+        f.evaluate(xs, fs, m);
+        SIO_PROFILE_MARK(FIND_PIECE);
 
-    return {mean, stdDev, ConfidenceInterval(mean, halfWidth), numGen, curTime};
+        for (size_t i = 0; i < m; ++i) {
+            gs[i] /= fs[i]; // Y = g(X) / f(X)
+        }
+        acc.add(gs, m);
+        SIO_PROFILE_MARK(ACCUMULATE);
+    }
 }
 
-void ImportanceSampling::setSeed(const std::seed_seq &seed) {
-    generator.setSeed(seed);
+double ImportanceSampling::scale() const {
+    // multiplication a la fin plutot que multiplier Y a chaque iteration dans la boucle
+    return generator.getPWLFunc().A;
 }
 
-void ImportanceSampling::sample(uint64_t step) {
+MonteCarloMethod::Sampling ImportanceSampling::createSampling(double timeElapsed) const {
+    Sampling sampling = MonteCarloMethod::createSampling(timeElapsed);
+    if (iterationSize > 0) {
+        sampling.N = numUsed; // les valeurs d'une iteration incomplete trop petite ne sont pas dans l'estimation
+    }
+    return sampling;
+}
+
+bool ImportanceSampling::supportsQuasiRandom() const {
+    return iterationSize == 0;
+}
+
+void ImportanceSampling::sampleQuasiBlock(const ScrambledSobol& sequence, uint64_t first, uint64_t n,
+                                          Accumulator& acc) const {
     const PiecewiseLinearFunction& f = generator.getPWLFunc();
+    double us[BATCH_SIZE], xs[BATCH_SIZE], gs[BATCH_SIZE], fs[BATCH_SIZE];
 
-    for (uint64_t i = 0; i < step; ++i) {
-        double X = generator.generate();
-        double Y = g(X) / f(X);
+    // les points de la suite sont transformes par la fonction de repartition inverse de f
+    for (uint64_t done = 0; done < n; done += BATCH_SIZE) {
+        size_t m = (size_t)std::min<uint64_t>(BATCH_SIZE, n - done);
 
-        sum += Y;
-        sumSquares += Y*Y;
+        sequence.points(first + done, us, m);
+        generator.inverseBatch(us, xs, m);
+
+        g->evaluate(xs, gs, m);
+        f.evaluate(xs, fs, m);
+
+        for (size_t i = 0; i < m; ++i) {
+            gs[i] /= fs[i]; // Y = g(X) / f(X)
+        }
+        acc.add(gs, m);
     }
+}
 
-    numGen += step;
+void ImportanceSampling::sampleIteration(uint64_t n) {
+    const PiecewiseLinearFunction& f = generator.getPWLFunc();
+    size_t numPieces = f.size();
 
-    // multiplication a la fin plutot que multiplier Y a chaque iteration dans la boucle
-    double tmpS = sum * f.A;
-    double tmpQ = sumSquares * (f.A * f.A);
+    uint64_t numTasks = (n + ADAPTIVE_TASK_SIZE - 1) / ADAPTIVE_TASK_SIZE;
+    uint64_t firstStream = nextStream;
+    std::vector<Accumulator> partials(numTasks);
+    std::vector<PieceSums> partialSums(numTasks * numPieces);
 
-    mean = tmpS/numGen;
-    double var = tmpQ/numGen - mean*mean;
-    stdDev = sqrt(var/numGen);
-    halfWidth = 1.96 * stdDev;
+    forEachTask(numTasks, [&](uint64_t t) {
+        RandomEngine engine(mtGenerator.getKind());
+        seedStream(engine, seedKey, firstStream + t);
+
+        double xs[BATCH_SIZE], gs[BATCH_SIZE];
+        PieceSums* sums = partialSums.data() + t * numPieces;
+        uint64_t size = std::min(ADAPTIVE_TASK_SIZE, n - t * ADAPTIVE_TASK_SIZE);
+
+        for (uint64_t done = 0; done < size; done += BATCH_SIZE) {
+            size_t m = (size_t)std::min<uint64_t>(BATCH_SIZE, size - done);
+            SIO_PROFILE_BATCH(m);
+            generator.generateBatch(engine, xs, m);
+            g->evaluate(xs, gs, m);
+            SIO_PROFILE_MARK(INTEGRAND);
+
+            // le morceau de X est necessaire pour ses poids: f(X) est evaluee sur ce morceau
+            for (size_t i = 0; i < m; ++i) {
+                uint64_t k = f.findPiece(xs[i]);
+                gs[i] /= f.evalPiece(k, xs[i]); // Y = g(X) / f(X)
+                sums[k].count += 1;
+                sums[k].sum += gs[i];
+                sums[k].sumSquares += gs[i] * gs[i];
+            }
+            partials[t].add(gs, m);
+            SIO_PROFILE_MARK(ACCUMULATE);
+        }
+    });
+
+    nextStream += numTasks;
+
+    // fusion dans l'ordre des taches: le resultat est independant de l'ordre d'execution
+    for (uint64_t t = 0; t < numTasks; ++t) {
+        iteration.merge(partials[t]);
+        for (size_t k = 0; k < numPieces; ++k) {
+            const PieceSums& p = partialSums[t * numPieces + k];
+            pieceSums[k].count += p.count;
+            pieceSums[k].sum += p.sum;
+            pieceSums[k].sumSquares += p.sumSquares;
+        }
+    }
 }
 
+void ImportanceSampling::endIteration() {
+    double A = scale();
+    double area = A * iteration.mean();
+    double var = A * A * iteration.variance() / iteration.count();
 
+    // une variance nulle (g proportionnelle a f) donnerait un poids infini
+    var = std::max(var, std::numeric_limits<double>::min());
+    sumInvVar += 1 / var;
+    sumWeightedAreas += area / var;
+    sumCounts += iteration.count();
+
+    // la densite est affinee tant qu'elle s'ameliore, sinon la meilleure est restauree et figee
+    const PiecewiseLinearFunction& f = generator.getPWLFunc();
+    double valueVar = A * A * iteration.variance();
+    if (!frozen) {
+        if (valueVar < bestVariance) {
+            bestVariance = valueVar;
+            bestXs = f.xs;
+            bestYs = f.ys;
+            refine();
+        } else {
+            generator.setPoints(bestXs, bestYs);
+            frozen = true;
+        }
+    }
+
+    iteration = Accumulator();
+    pieceSums.assign(generator.getPWLFunc().size(), PieceSums());
+}
+
+void ImportanceSampling::refine() {
+    const PiecewiseLinearFunction& f = generator.getPWLFunc();
+    size_t K = f.size();
+    if (K < 2) {
+        return;
+    }
+
+    // contribution de chaque morceau a la variance: somme des (Y - moyenne)^2 des valeurs tombees dans le morceau
+    double c = iteration.mean();
+    std::vector<double> contributions(K);
+    for (size_t k = 0; k < K; ++k) {
+        const PieceSums& p = pieceSums[k];
+        contributions[k] = std::max(0.0, p.sumSquares - 2 * c * p.sum + p.count * c * c);
+    }
+
+    // poids lisses avec les morceaux voisins puis amortis (VEGAS): ((1 - r) / ln(1/r))^alpha, r etant la part du
+    // morceau
+    std::vector<double> weights(K);
+    double total = 0;
+    for (size_t k = 0; k < K; ++k) {
+        double prev = contributions[k > 0 ? k - 1 : k], next = contributions[k + 1 < K ? k + 1 : k];
+        weights[k] = (prev + contributions[k] + next) / 3;
+        total += weights[k];
+    }
+    if (!(total > 0) || std::isinf(total)) {
+        return;
+    }
+
+    double dampedTotal = 0;
+    for (double& w : weights) {
+        double r = w / total;
+        w = r <= 0 ? 0 : r >= 1 ? 1 : pow((1 - r) / log(1 / r), DAMPING);
+        dampedTotal += w;
+    }
+
+    // nouvelles abscisses: chaque nouveau morceau recoit la meme part des poids amortis
+    std::vector<double> xs(K + 1), ys(K + 1);
+    xs[0] = f.xs[0];
+    xs[K] = f.xs[K];
+
+    size_t k = 0;
+    double cumulated = 0;
+    for (size_t j = 1; j < K; ++j) {
+        double target = dampedTotal * j / K;
+        while (k + 1 < K && cumulated + weights[k] < target) {
+            cumulated += weights[k++];
+        }
+
+        double t = weights[k] > 0 ? std::min((target - cumulated) / weights[k], 1.0) : 0;
+        xs[j] = f.xs[k] + t * (f.xs[k + 1] - f.xs[k]);
+        if (xs[j] <= xs[j - 1]) {
+            return; // points confondus (arrondis): on garde la densite actuelle
+        }
+    }
+    if (xs[K] <= xs[K - 1]) {
+        return;
+    }
+
+    // nouvelles ordonnees: |g| aux nouveaux points, avec un minimum afin que f reste positive
+    g->evaluate(xs.data(), ys.data(), K + 1);
+
+    double yMax = 0;
+    for (double& y : ys) {
+        y = std::fabs(y);
+        yMax = std::max(yMax, y);
+    }
+    if (!(yMax > 0) || std::isinf(yMax)) {
+        return;
+    }
+    for (double& y : ys) {
+        y = std::max(y, MIN_RELATIVE_DENSITY * yMax);
+    }
+
+    generator.setPoints(xs, ys);
+}
+
+void ImportanceSampling::saveState(StateWriter& out) const {
+    if (iterationSize == 0) {
+        MonteCarloMethod::saveState(out);
+        return;
+    }
+
+    // l'iteration en cours est mise a l'echelle de la densite de ce processus, seule valable pour ses valeurs
+    double invVar = sumInvVar, weightedAreas = sumWeightedAreas;
+    uint64_t count = sumCounts;
+    addPartialIteration(iteration, invVar, weightedAreas, count);
+
+    out.writeUInt(numGen);
+    out.writeUInt(count);
+    out.writeDouble(invVar);
+    out.writeDouble(weightedAreas);
+}
+
+void ImportanceSampling::mergeStates(const std::vector<std::string>& states) {
+    if (iterationSize == 0) {
+        MonteCarloMethod::mergeStates(states);
+        return;
+    }
+
+    // les sommes de chaque processus sont deja a l'echelle des aires: il suffit de les additionner
+    numGen = 0;
+    sumInvVar = 0;
+    sumWeightedAreas = 0;
+    sumCounts = 0;
+    for (const std::string& state : states) {
+        StateReader in(state);
+        numGen += in.readUInt();
+        sumCounts += in.readUInt();
+        sumInvVar += in.readDouble();
+        sumWeightedAreas += in.readDouble();
+        if (!in.atEnd()) {
+            throw std::runtime_error("Etat d'echantillonnage incompatible.");
+        }
+    }
+
+    iteration = Accumulator();
+    updateAdaptiveStatistics();
+}
+
+void ImportanceSampling::addPartialIteration(const Accumulator& values, double& invVar, double& weightedAreas,
+                                             uint64_t& count) const {
+    uint64_t n = values.count();
+    if (n >= 2 && (invVar == 0 || 2 * n >= iterationSize)) {
+        double A = scale();
+        double var = std::max(A * A * values.variance() / n, std::numeric_limits<double>::min());
+        invVar += 1 / var;
+        weightedAreas += A * values.mean() / var;
+        count += n;
+    }
+}
+
+void ImportanceSampling::updateAdaptiveStatistics() {
+    double invVar = sumInvVar, weightedAreas = sumWeightedAreas;
+    numUsed = sumCounts;
+
+    // iteration en cours, si elle est assez grande pour que sa variance soit fiable
+    addPartialIteration(iteration, invVar, weightedAreas, numUsed);
+
+    if (invVar == 0) {
+        mean = 0;
+        stdDev = std::numeric_limits<double>::infinity();
+    } else {
+        mean = weightedAreas / invVar / scale();
+        stdDev = sqrt(1 / invVar);
+    }
+    halfWidth = 1.96 * stdDev;
+}
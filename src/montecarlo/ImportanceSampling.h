@@ -6,41 +6,178 @@
 
 /**
  * Represente la methode d'integration par echantillonnage preferentiel.
+ *
+ * En mode adaptatif (voir setAdaptive), la densite est affinee pendant l'echantillonnage, dans l'esprit de VEGAS:
+ * apres chaque iteration (un nombre fixe de valeurs generees avec la meme densite), les abscisses des points de la
+ * densite sont deplacees afin que chaque morceau contribue autant a la variance des poids g(X) / f(X) observes, puis
+ * les ordonnees sont recalculees a partir de |g|. Des qu'une densite affinee donne une variance plus grande que la
+ * meilleure densite, cette derniere est restauree et n'est plus modifiee. Les estimations des iterations sont
+ * combinees en les ponderant par l'inverse de leur variance.
+ *
+ * Seule la fonction g est un parametre de modele (voir le constructeur template): le generateur est toujours
+ * InverseFunctions, le seul qui tire selon une densite affine par morceaux. Un parametre de modele pour le generateur
+ * dupliquerait la classe sans autre gain que la mise en ligne de generateBatch, dont le cout est amorti sur un lot.
  */
 class ImportanceSampling : public MonteCarloMethod {
 private:
-    // generateur de variables aleatoires utilisant la methode des melanges couplee a la methode des fonctions inverses
+    // generateur de variables aleatoires utilisant la methode des melanges couplee a la methode des fonctions inverses.
+    // Son type est concret et InverseFunctions est finale: les appels sont resolus a la compilation (un appel non
+    // virtuel a generateBatch par lot de BATCH_SIZE valeurs), sans parametre de modele pour le generateur.
     InverseFunctions generator;
 
-public:
-    ImportanceSampling(const Func& g, const std::vector<double>& xs, const std::vector<double>& ys);
+    /**
+     * Sommes des valeurs tombees dans un morceau de la densite (mode adaptatif).
+     */
+    struct PieceSums {
+        uint64_t count = 0;
+        double sum = 0, sumSquares = 0;
+    };
+
+    std::vector<double> initialXs, initialYs; // points de la densite initiale (restauree a chaque echantillonnage)
+
+    uint64_t iterationSize = 0;       // nombre de valeurs par iteration en mode adaptatif (0: densite fixe)
+    uint64_t nextStream = 0;          // indice du prochain flux a utiliser en mode adaptatif
+
+    Accumulator iteration;            // valeurs g(X) / f(X) de l'iteration en cours
+    std::vector<PieceSums> pieceSums; // sommes des valeurs par morceau, pour l'iteration en cours
+    double sumInvVar;                 // somme des inverses des variances des iterations terminees
+    double sumWeightedAreas;          // somme des aires estimees des iterations terminees, ponderees
+    uint64_t sumCounts;               // nombre de valeurs des iterations terminees
+    uint64_t numUsed = 0;             // nombre de valeurs prises en compte dans l'estimation et l'IC
+
+    std::vector<double> bestXs, bestYs; // points de la meilleure densite (plus petite variance par valeur)
+    double bestVariance;                // variance par valeur de l'aire estimee avec la meilleure densite
+    bool frozen;                        // si la densite n'est plus affinee
 
+public:
     /**
-     * @see MontecarloMethod::sampleWithSize.
+     * Prepare la methode.
+     *
+     * @param g La fonction dont on veut estimer l'aire.
+     * @param xs Les abscisses des points de la densite a utiliser (sous forme de fonction par morceaux).
+     * @param ys Les ordonnees des points de la densite a utiliser (sous forme de fonction par morceaux).
      */
-    Sampling sampleWithSize(uint64_t N);
+    ImportanceSampling(const Func& g, const std::vector<double>& xs, const std::vector<double>& ys);
+
     /**
-     * @see MontecarloMethod::sampleWithMaxWidth.
+     * Prepare la methode avec une fonction dont le type est connu a la compilation (ex: lambda): les appels a g dans
+     * la boucle d'echantillonnage sont alors mis en ligne. Une fonction de signature
+     * void(const double*, double*, size_t) (voir BatchFunc) est evaluee directement sur les lots de points generes.
+     *
+     * @see ImportanceSampling(const Func&, const std::vector<double>&, const std::vector<double>&).
      */
-    Sampling sampleWithMaxWidth(double maxWidth, uint64_t step);
+    template <typename G>
+    ImportanceSampling(G g, const std::vector<double>& xs, const std::vector<double>& ys)
+            : ImportanceSampling(makeIntegrand(std::move(g)), xs, ys) {}
+
     /**
-     * @see MontecarloMethod::sampleWithMinTime.
+     * @see ImportanceSampling(const Func&, const std::vector<double>&, const std::vector<double>&).
      */
-    Sampling sampleWithMinTime(double maxTime, uint64_t step);
+    ImportanceSampling(std::unique_ptr<const Integrand> g, const std::vector<double>& xs, const std::vector<double>& ys);
 
     /**
      * @see MonteCarloMethod::setSeed.
      */
     void setSeed(const std::seed_seq& seed);
 
-private:
     /**
-     * Effectue un certain nombre donne de generations afin de mettre a jour les statistiques (somme, somme des
-     * carres, moyenne, etc) et de creer un IC pour l'aire estimee.
+     * Active le mode adaptatif. Chaque iteration utilise son propre flux aleatoire par tranche de valeurs (derive de
+     * la graine): le resultat ne depend pas du nombre de threads. Les valeurs d'une iteration incomplete ne sont
+     * prises en compte que si elle contient au moins la moitie des valeurs d'une iteration (ou si aucune iteration
+     * n'est terminee): sur moins de valeurs, sa variance estimee, qui fixe son poids, n'est pas fiable. Les valeurs
+     * ignorees ne sont pas comptees dans la taille de l'echantillon (Sampling::N), seulement dans le nombre
+     * d'evaluations (Sampling::numEvaluations). En mode reparti, chaque processus applique cette regle a sa propre
+     * iteration en cours.
      *
-     * @param step Le nombre de generation qui seront effectuees.
+     * @param size Le nombre de valeurs generees avant d'affiner la densite, ou 0 pour utiliser une densite fixe.
+     * @throw std::invalid_argument Si le mode quasi-Monte Carlo randomise est active.
+     */
+    void setAdaptive(uint64_t size);
+
+protected:
+    /**
+     * Restaure la densite initiale (mode adaptatif).
+     */
+    void prepare();
+
+    /**
+     * @see MonteCarloMethod::sample.
      */
     void sample(uint64_t step);
+
+    /**
+     * @see MonteCarloMethod::sampleBlock.
+     */
+    void sampleBlock(RandomEngine& engine, uint64_t n, Accumulator& acc) const;
+
+    /**
+     * @see MonteCarloMethod::scale.
+     */
+    double scale() const;
+
+    /**
+     * @see MonteCarloMethod::saveState. En mode adaptatif, l'etat contient les sommes de la combinaison des iterations
+     * de ce processus, l'iteration en cours y etant ajoutee avec la densite (et donc le facteur scale()) du processus.
+     */
+    void saveState(StateWriter& out) const;
+
+    /**
+     * @see MonteCarloMethod::mergeStates. En mode adaptatif, chaque processus affine sa propre densite: les
+     * iterations de tous les processus sont combinees en les ponderant par l'inverse de leur variance. Les sommes
+     * recues etant deja a l'echelle des aires, elles sont simplement additionnees.
+     */
+    void mergeStates(const std::vector<std::string>& states);
+
+    /**
+     * @see MonteCarloMethod::createSampling. En mode adaptatif, la taille de l'echantillon est le nombre de valeurs
+     * prises en compte dans l'estimation (voir setAdaptive).
+     */
+    Sampling createSampling(double timeElapsed) const;
+
+    /**
+     * @see MonteCarloMethod::supportsQuasiRandom.
+     */
+    bool supportsQuasiRandom() const;
+
+    /**
+     * @see MonteCarloMethod::sampleQuasiBlock.
+     */
+    void sampleQuasiBlock(const ScrambledSobol& sequence, uint64_t first, uint64_t n,
+                          Accumulator& acc) const;
+
+private:
+    /**
+     * Genere des valeurs de l'iteration en cours (mode adaptatif), en parallele en mode parallele.
+     *
+     * @param n Le nombre de valeurs a generer (au plus le nombre de valeurs manquant a l'iteration).
+     */
+    void sampleIteration(uint64_t n);
+
+    /**
+     * Termine l'iteration en cours: ajoute son estimation a la combinaison et affine la densite.
+     */
+    void endIteration();
+
+    /**
+     * Deplace les points de la densite selon les poids des morceaux observes durant l'iteration en cours.
+     */
+    void refine();
+
+    /**
+     * Ajoute l'estimation d'une iteration incomplete a une combinaison, si elle est assez grande pour que sa variance
+     * soit fiable (voir setAdaptive).
+     *
+     * @param values Les valeurs de l'iteration.
+     * @param invVar La somme des inverses des variances de la combinaison.
+     * @param weightedAreas La somme des aires ponderees de la combinaison.
+     * @param count Le nombre de valeurs de la combinaison.
+     */
+    void addPartialIteration(const Accumulator& values, double& invVar, double& weightedAreas, uint64_t& count) const;
+
+    /**
+     * Met a jour la moyenne, l'ecart-type et la demi-largeur de l'IC a partir des estimations des iterations.
+     */
+    void updateAdaptiveStatistics();
 };
 
 #endif // IMPORTANCE_SAMPLING_H
@@ -0,0 +1,121 @@
+#ifndef INTEGRAND_H
+#define INTEGRAND_H
+
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <cstddef>
+
+/**
+ * Represente la fonction dont on veut estimer l'aire, evaluee par lots par les methodes.
+ *
+ * Le type concret de la fonction est connu de BasicIntegrand: l'appel virtuel n'est fait qu'une fois par lot, et
+ * la boucle d'evaluation peut etre mise en ligne et vectorisee par le compilateur. Une fonction peut aussi etre
+ * donnee directement par lots (voir BatchIntegrand), par exemple pour utiliser les fonctions de FastMath.
+ */
+class Integrand {
+public:
+    virtual ~Integrand() = default;
+
+    /**
+     * Evalue la fonction en un point.
+     *
+     * @param x L'abscisse.
+     * @return L'ordonnee.
+     */
+    virtual double operator()(double x) const = 0;
+
+    /**
+     * Evalue la fonction sur un lot de points. Peut etre appelee simultanement depuis plusieurs threads.
+     *
+     * @param x Les abscisses.
+     * @param y Le tampon dans lequel ecrire les ordonnees.
+     * @param n Le nombre de points.
+     */
+    virtual void evaluate(const double* x, double* y, size_t n) const = 0;
+};
+
+/**
+ * Fonction dont le type est connu a la compilation (lambda, foncteur, std::function, ...).
+ *
+ * @tparam G Le type de la fonction: doit pouvoir etre appelee sur un objet constant avec un double.
+ */
+template <typename G>
+class BasicIntegrand final : public Integrand {
+private:
+    G g;
+
+public:
+    explicit BasicIntegrand(G g) : g(std::move(g)) {}
+
+    double operator()(double x) const {
+        return g(x);
+    }
+
+    void evaluate(const double* x, double* y, size_t n) const {
+        for (size_t i = 0; i < n; ++i) {
+            y[i] = g(x[i]);
+        }
+    }
+};
+
+/**
+ * Fonction evaluee par lots, de signature void(const double* x, double* y, size_t n): elle ecrit dans y[i] la valeur
+ * de la fonction en x[i] pour i < n. Les points isoles sont evalues comme des lots de taille 1.
+ *
+ * @tparam G Le type de la fonction: doit pouvoir etre appelee sur un objet constant.
+ */
+template <typename G>
+class BatchIntegrand final : public Integrand {
+private:
+    G g;
+
+public:
+    explicit BatchIntegrand(G g) : g(std::move(g)) {}
+
+    double operator()(double x) const {
+        double y;
+        g(&x, &y, 1);
+        return y;
+    }
+
+    void evaluate(const double* x, double* y, size_t n) const {
+        g(x, y, n);
+    }
+};
+
+/**
+ * Indique si une fonction s'evalue par lots (voir BatchIntegrand).
+ */
+template <typename G>
+class IsBatchFunction {
+private:
+    template <typename T>
+    static auto test(int) -> decltype(std::declval<const T&>()(std::declval<const double*>(), std::declval<double*>(),
+                                                              std::declval<size_t>()), std::true_type());
+
+    template <typename T>
+    static std::false_type test(...);
+
+public:
+    static const bool value = decltype(test<G>(0))::value;
+};
+
+/**
+ * Cree la fonction a estimer a partir d'une fonction de type quelconque: evaluee par lots si elle en a la signature
+ * (voir BatchIntegrand), point par point sinon.
+ *
+ * @param g La fonction.
+ * @return La fonction a utiliser par les methodes.
+ */
+template <typename G>
+typename std::enable_if<!IsBatchFunction<G>::value, std::unique_ptr<const Integrand>>::type makeIntegrand(G g) {
+    return std::unique_ptr<const Integrand>(new BasicIntegrand<G>(std::move(g)));
+}
+
+template <typename G>
+typename std::enable_if<IsBatchFunction<G>::value, std::unique_ptr<const Integrand>>::type makeIntegrand(G g) {
+    return std::unique_ptr<const Integrand>(new BatchIntegrand<G>(std::move(g)));
+}
+
+#endif // INTEGRAND_H
@@ -1,11 +1,647 @@
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
 #include "MonteCarloMethod.h"
+#include "../distributed/WorkerChannel.h"
+
+// arret predictif (voir sampleWithMaxWidth): taille de la phase pilote (en points par replicat en mode quasi-Monte
+// Carlo), fraction du reste predit generee d'un coup, reste en-deca duquel il est genere en entier, et croissance
+// maximale de l'echantillon par etape
+static const uint64_t PILOT_SIZE = 1000;
+static const uint64_t QUASI_PILOT_POINTS = 64;
+static const double JUMP_FRACTION = 0.9;
+static const double REFINE_SIZE = 10 * BATCH_SIZE;
+static const double MAX_GROWTH = 10;
+
+// messages du mode reparti: preparation d'un echantillonnage (indice de flux et graine), etape (nombre de
+// generations), fin de l'echantillonnage, et reponses (etat, ou message d'erreur)
+static const char START_MESSAGE = 'S';
+static const char STEP_MESSAGE = 'N';
+static const char END_MESSAGE = 'E';
+static const char STATE_MESSAGE = 'T';
+static const char ERROR_MESSAGE = 'X';
+
+/**
+ * @return Le temps moyen (en secondes) d'une lecture de l'horloge.
+ */
+static double clockReadCost() {
+    typedef std::chrono::steady_clock Clock;
+    const int numReads = 64;
+
+    Clock::time_point beg = Clock::now();
+    for (int i = 0; i < numReads; ++i) {
+        Clock::now();
+    }
+    return std::chrono::duration<double>(Clock::now() - beg).count() / numReads;
+}
+
+/**
+ * Enveloppe d'une fonction comptant ses evaluations (voir MonteCarloMethod::setTelemetry): une mise a jour des
+ * compteurs du thread par lot.
+ */
+class CountedIntegrand final : public Integrand {
+private:
+    std::unique_ptr<const Integrand> g;
+    Telemetry* telemetry = nullptr;
+
+public:
+    explicit CountedIntegrand(std::unique_ptr<const Integrand> g) : g(std::move(g)) {}
+
+    void setTelemetry(Telemetry* telemetry) {
+        this->telemetry = telemetry;
+    }
+
+    double operator()(double x) const {
+        if (telemetry) {
+            telemetry->addEvaluations(1);
+        }
+        return (*g)(x);
+    }
+
+    void evaluate(const double* x, double* y, size_t n) const {
+        g->evaluate(x, y, n);
+        if (telemetry) {
+            telemetry->addEvaluations(n);
+        }
+    }
+};
+
+MonteCarloMethod::MonteCarloMethod(std::unique_ptr<const Integrand> g) : g(std::move(g)) {}
+
+MonteCarloMethod::~MonteCarloMethod() = default;
+
+void MonteCarloMethod::setSeed(const std::seed_seq& seed) {
+    seedEngine(mtGenerator, seed);
+    seedKey = seedParams(seed);
+    nextShard = 0;
+    nextWorker = 0;
+}
+
+void MonteCarloMethod::setEngine(RandomEngine::Kind kind) {
+    mtGenerator = RandomEngine(kind);
+
+    if (!seedKey.empty()) {
+        std::seed_seq seed(seedKey.begin(), seedKey.end());
+        mtGenerator.seed(seed);
+    }
+    nextShard = 0;
+}
+
+void MonteCarloMethod::setTelemetry(Telemetry* telemetry) {
+    // la fonction n'est enveloppee qu'une fois: sans compteurs, l'enveloppe ne coute qu'un test par lot
+    if (!counted && telemetry) {
+        counted = new CountedIntegrand(std::move(g));
+        g.reset(counted);
+    }
+    if (counted) {
+        counted->setTelemetry(telemetry);
+    }
+    this->telemetry = telemetry;
+}
+
+void MonteCarloMethod::setNumThreads(unsigned numThreads) {
+    if (numThreads == 0) {
+        pool.reset();
+    } else {
+        pool.reset(new ThreadPool(numThreads));
+    }
+}
+
+void MonteCarloMethod::setNumProcesses(unsigned numProcesses) {
+    this->numProcesses = numProcesses;
+}
+
+void MonteCarloMethod::setRemoteWorkers(const std::vector<std::string>& socketPaths) {
+    remoteWorkers = socketPaths;
+}
+
+void MonteCarloMethod::serveWorker(const std::string& socketPath) {
+    WorkerChannel::listen(socketPath, [this](WorkerChannel& channel) {
+        serveSampling(channel);
+    });
+}
+
+void MonteCarloMethod::setShardSize(uint64_t size) {
+    if (size == 0) {
+        throw std::invalid_argument("La taille d'un shard doit etre au moins egale a 1.");
+    }
+    shardSize = size;
+}
+
+void MonteCarloMethod::setQuasiRandom(unsigned numReplicates) {
+    if (numReplicates == 0) {
+        sequences.clear();
+        return;
+    }
+
+    if (!supportsQuasiRandom()) {
+        throw std::invalid_argument("Le mode quasi-Monte Carlo n'est pas disponible pour cette methode.");
+    }
+    if (numReplicates < 2) {
+        throw std::invalid_argument("Il faut au moins 2 replicats pour construire un IC.");
+    }
+
+    sequences.assign(numReplicates, ScrambledSobol());
+}
+
+void MonteCarloMethod::setAntithetic(bool enabled) {
+    if (enabled && !supportsAntithetic()) {
+        throw std::invalid_argument("Le mode antithetique n'est pas disponible pour cette methode.");
+    }
+    antithetic = enabled;
+}
+
+MonteCarloMethod::Sampling MonteCarloMethod::sampleWithSize(uint64_t N) {
+    begin();
+
+    if (N < numGen) {
+        throw std::invalid_argument("N est plus petit que la taille de la phase preliminaire.");
+    }
+
+    runStep(N - numGen);
+    return finish(elapsedTime());
+}
+
+MonteCarloMethod::Sampling MonteCarloMethod::sampleWithMaxWidth(double maxWidth, uint64_t step) {
+    begin();
+
+    // genere des valeurs tant que la largeur de l'intervalle de confiance est plus grande que "maxWidth"
+    do {
+        runStep(step);
+    } while (halfWidth * 2 > maxWidth);
+
+    return finish(elapsedTime());
+}
+
+MonteCarloMethod::Sampling MonteCarloMethod::sampleWithMaxWidth(double maxWidth) {
+    if (maxWidth <= 0) {
+        throw std::invalid_argument("La largeur maximale de l'IC doit etre strictement positive.");
+    }
+
+    begin();
+
+    // en mode quasi-Monte Carlo, le nombre de points par replicat reste une puissance de 2 (voir setQuasiRandom)
+    bool quasiRandom = !sequences.empty();
+    uint64_t pilotSize = quasiRandom ? sequences.size() * QUASI_PILOT_POINTS : PILOT_SIZE;
+
+    double targetHalfWidth = maxWidth / 2;
+    uint64_t step = numGen < pilotSize ? pilotSize - numGen : BATCH_SIZE;
+
+    while (true) {
+        runStep(step);
 
-MonteCarloMethod::MonteCarloMethod(const std::function<double(double)>& func) : g(func) {}
+        // regle de Chow-Robbins: la variance par valeur est majoree de 1/n, soit scale()^2 / n^2 pour la variance de
+        // l'aire estimee (stdDev est a l'echelle de l'aire)
+        double n = (double)numGen;
+        double s = scale();
+        double guardedVar = stdDev * stdDev + s * s / (n * n);
+        if (1.96 * sqrt(guardedVar) <= targetHalfWidth) {
+            break;
+        }
+
+        // nombre total de valeurs necessaires si la variance reste la meme
+        double needed = 1.96 * 1.96 * guardedVar * n / (targetHalfWidth * targetHalfWidth);
+        double remaining = needed - n;
+
+        // en mode quasi-Monte Carlo, l'IC decroit plus vite que 1/sqrt(n) et la prediction n'est pas fiable: on
+        // double l'echantillon
+        if (quasiRandom) {
+            step = numGen;
+            continue;
+        }
+
+        // saut vers la plus grande partie du reste (affinee a l'etape suivante), limite tant que la variance est
+        // estimee sur peu de valeurs
+        double next = remaining > REFINE_SIZE ? JUMP_FRACTION * remaining : remaining;
+        next = std::min(next, MAX_GROWTH * n);
+        step = std::max<uint64_t>(BATCH_SIZE, (uint64_t)ceil(next));
+    }
+
+    return finish(elapsedTime());
+}
+
+MonteCarloMethod::Sampling MonteCarloMethod::sampleWithMinTime(double minTime, uint64_t step) {
+    begin();
+
+    double curTime = 0;
+
+    // genere des valeurs tant que le temps minimal d'execution n'est pas atteint (temps reel: le temps processeur
+    // compterait plusieurs fois le temps passe en mode parallele)
+    do {
+        Clock::time_point beg = Clock::now();
+        runStep(step);
+        curTime += std::chrono::duration<double>(Clock::now() - beg).count();
+    } while (curTime < minTime);
+
+    return finish(curTime);
+}
+
+MonteCarloMethod::Sampling MonteCarloMethod::sampleWithDeadline(double minTime, double maxTime) {
+    if (minTime < 0 || maxTime < minTime) {
+        throw std::invalid_argument("Le temps maximum doit etre plus grand ou egal au temps minimum (positif).");
+    }
+
+    // la phase preliminaire (ex: pilote de la variable de controle) compte dans le temps, bien qu'elle ne puisse pas
+    // etre interrompue
+    Clock::time_point callStart = Clock::now();
+    begin();
+
+    // une verification (lecture de l'horloge, mise a jour des statistiques) doit couter moins de 1% d'une etape, et
+    // une etape ne doit pas depasser la tolerance afin de borner le depassement de l'echeance
+    double minStepTime = 100 * clockReadCost();
+    double maxStepTime = std::max(minStepTime, deadlineTolerance * minTime);
+
+    // premiere etape d'une seule valeur (le cout d'une valeur est inconnu et peut etre grand), puis croissance
+    // geometrique limitee
+    uint64_t step = 1;
+    double curTime = std::chrono::duration<double>(Clock::now() - callStart).count();
+
+    // la limite dure est verifiee avant chaque etape, y compris juste apres la phase preliminaire: on s'arrete si la
+    // marge de 100% ne laisse pas le temps d'une etape
+    while (curTime < minTime && (maxTime - curTime) / 2 >= minStepTime) {
+        uint64_t numBefore = numGen;
+        Clock::time_point beg = Clock::now();
+        runStep(step);
+        Clock::time_point end = Clock::now();
+
+        curTime = std::chrono::duration<double>(end - callStart).count();
+        double stepTime = std::chrono::duration<double>(end - beg).count();
+        double costPerValue = std::max(stepTime, 1e-9) / std::max<uint64_t>(1, numGen - numBefore);
+
+        // duree visee pour la prochaine etape: finir a l'echeance, avec une marge de 100% pour la limite dure
+        double capTime = (maxTime - curTime) / 2;
+        double targetTime = std::min(std::min(maxStepTime, minTime - curTime), capTime);
+        targetTime = std::max(targetTime, minStepTime);
+
+        // la croissance est limitee: le cout mesure sur une petite etape est peu fiable
+        double nextStep = std::min(targetTime / costPerValue, 8.0 * step);
+        step = std::max<uint64_t>(1, (uint64_t)nextStep);
+    }
+
+    return finish(curTime);
+}
+
+void MonteCarloMethod::setDeadlineTolerance(double tolerance) {
+    if (tolerance <= 0) {
+        throw std::invalid_argument("La tolerance doit etre strictement positive.");
+    }
+    deadlineTolerance = tolerance;
+}
 
 void MonteCarloMethod::init() {
-    sum = 0;
-    sumSquares = 0;
+    values = Accumulator();
     numGen = 0;
 
-    start = clock();
+    // nouveaux brouillages a chaque echantillonnage (comme le generateur, ils dependent de la graine)
+    for (ScrambledSobol& sequence : sequences) {
+        sequence.scramble(mtGenerator);
+    }
+    replicates.assign(sequences.size(), Accumulator());
+    pointsPerReplicate = 0;
+
+    start = Clock::now();
+}
+
+void MonteCarloMethod::prepare() {
+    init();
+}
+
+void MonteCarloMethod::sample(uint64_t step) {
+    if (!sequences.empty()) {
+        sampleReplicates(step);
+        updateReplicateStatistics();
+        return;
+    }
+
+    if (pool) {
+        sampleShards(step);
+    } else {
+        sampleBlock(mtGenerator, step, values);
+    }
+
+    numGen += step;
+    updateStatistics();
+}
+
+void MonteCarloMethod::begin() {
+    if (numProcesses == 0 && remoteWorkers.empty()) {
+        prepare();
+        return;
+    }
+
+    // les phases preliminaires sont effectuees par les processus
+    init();
+    startWorkers();
+}
+
+MonteCarloMethod::Sampling MonteCarloMethod::finish(double timeElapsed) {
+    stopWorkers();
+    return createSampling(timeElapsed);
+}
+
+void MonteCarloMethod::runStep(uint64_t step) {
+    if (channels.empty()) {
+        sample(step);
+    } else {
+        sampleWorkers(step);
+    }
+
+    if (telemetry) {
+        telemetry->publish(numGen, elapsedTime(), scale() * mean, halfWidth);
+    }
+}
+
+void MonteCarloMethod::saveState(StateWriter& out) const {
+    if (!sequences.empty()) {
+        out.writeUInt(replicates.size());
+        for (const Accumulator& replicate : replicates) {
+            out.writeAccumulator(replicate);
+        }
+        return;
+    }
+
+    out.writeAccumulator(values);
+}
+
+void MonteCarloMethod::mergeStates(const std::vector<std::string>& states) {
+    values = Accumulator();
+    replicates.clear();
+
+    for (const std::string& state : states) {
+        StateReader in(state);
+        if (!sequences.empty()) {
+            // les replicats des processus sont brouilles independamment: ce sont des replicats supplementaires
+            uint64_t numReplicates = in.readUInt();
+            for (uint64_t r = 0; r < numReplicates; ++r) {
+                replicates.push_back(in.readAccumulator());
+            }
+        } else {
+            values.merge(in.readAccumulator());
+        }
+
+        if (!in.atEnd()) {
+            throw std::runtime_error("Etat d'echantillonnage incompatible.");
+        }
+    }
+
+    if (!sequences.empty()) {
+        numGen = 0;
+        for (const Accumulator& replicate : replicates) {
+            numGen += replicate.count();
+        }
+        updateReplicateStatistics();
+    } else {
+        numGen = values.count();
+        updateStatistics();
+    }
+}
+
+void MonteCarloMethod::updateStatistics() {
+    double s = scale();
+
+    // variance calculee a partir des ecarts a la moyenne: jamais negative, meme pour de tres grands echantillons
+    mean = values.mean();
+    stdDev = s * sqrt(values.variance() / numGen);
+    halfWidth = 1.96 * stdDev;
+}
+
+uint64_t MonteCarloMethod::numBlocks(uint64_t n) const {
+    return pool ? (n + shardSize - 1) / shardSize : 1;
+}
+
+void MonteCarloMethod::runBlocks(uint64_t n, const BlockTask& task) {
+    if (!pool) {
+        task(0, mtGenerator, n);
+        return;
+    }
+
+    uint64_t numShards = numBlocks(n);
+    uint64_t firstShard = nextShard;
+
+    pool->parallelFor(numShards, [&](uint64_t i) {
+        RandomEngine engine(mtGenerator.getKind());
+        seedStream(engine, seedKey, firstShard + i);
+        task(i, engine, std::min(shardSize, n - i * shardSize));
+    });
+
+    nextShard += numShards;
+}
+
+void MonteCarloMethod::forEachTask(uint64_t numTasks, const ThreadPool::Task& task) {
+    if (pool) {
+        pool->parallelFor(numTasks, task);
+    } else {
+        for (uint64_t i = 0; i < numTasks; ++i) {
+            task(i);
+        }
+    }
+}
+
+bool MonteCarloMethod::supportsQuasiRandom() const {
+    return false;
+}
+
+bool MonteCarloMethod::supportsAntithetic() const {
+    return false;
+}
+
+bool MonteCarloMethod::isQuasiRandom() const {
+    return !sequences.empty();
+}
+
+void MonteCarloMethod::sampleQuasiBlock(const ScrambledSobol&, uint64_t, uint64_t, Accumulator&) const {
+    throw std::logic_error("Le mode quasi-Monte Carlo n'est pas disponible pour cette methode.");
+}
+
+MonteCarloMethod::Sampling MonteCarloMethod::createSampling(double timeElapsed) const {
+    double areaEstimator = scale() * mean;
+    uint64_t numEvaluations = antithetic ? 2 * numGen : numGen;
+    return {areaEstimator, stdDev, ConfidenceInterval(areaEstimator, halfWidth), numGen, timeElapsed, numEvaluations};
+}
+
+double MonteCarloMethod::elapsedTime() const {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void MonteCarloMethod::sampleShards(uint64_t step) {
+    std::vector<Accumulator> partials(numBlocks(step));
+
+    runBlocks(step, [&](uint64_t i, RandomEngine& engine, uint64_t n) {
+        sampleBlock(engine, n, partials[i]);
+    });
+
+    // fusion dans l'ordre des shards: le resultat est independant de l'ordre d'execution
+    for (const Accumulator& p : partials) {
+        values.merge(p);
+    }
+}
+
+void MonteCarloMethod::sampleReplicates(uint64_t step) {
+    uint64_t numReplicates = sequences.size();
+    uint64_t n = std::max<uint64_t>(1, step / numReplicates);
+
+    // les replicats sont independants: chacun peut etre traite par un thread different
+    ThreadPool::Task task = [&](uint64_t r) {
+        sampleQuasiBlock(sequences[r], pointsPerReplicate, n, replicates[r]);
+    };
+
+    forEachTask(numReplicates, task);
+
+    pointsPerReplicate += n;
+    numGen = numReplicates * pointsPerReplicate;
+}
+
+void MonteCarloMethod::updateReplicateStatistics() {
+    double s = scale();
+
+    // estimation de l'aire par chaque replicat
+    std::vector<double> areas;
+    areas.reserve(sequences.size());
+    for (const Accumulator& replicate : replicates) {
+        areas.push_back(s * replicate.mean());
+    }
+
+    ConfidenceInterval ci = Stats::confidenceInterval(areas, 1.96);
+
+    mean = Stats::mean(areas) / s;
+    stdDev = Stats::sampleStdDev(areas) / sqrt(areas.size());
+    halfWidth = ci.width / 2;
+}
+
+void MonteCarloMethod::startWorkers() {
+    stopWorkers();
+
+    for (unsigned w = 0; w < numProcesses; ++w) {
+        channels.push_back(WorkerChannel::spawn([this](WorkerChannel& channel) {
+            detachWorker();
+            serveSampling(channel);
+        }));
+    }
+    for (const std::string& path : remoteWorkers) {
+        channels.push_back(WorkerChannel::connect(path));
+    }
+
+    // un flux par processus et par echantillonnage, derive de la graine (comme les shards)
+    for (size_t w = 0; w < channels.size(); ++w) {
+        StateWriter message;
+        message.writeUInt(nextWorker + w);
+        message.writeUInt(seedKey.size());
+        for (uint32_t param : seedKey) {
+            message.writeUInt(param);
+        }
+        channels[w]->send(START_MESSAGE, message.data());
+    }
+    nextWorker += channels.size();
+
+    // les processus effectuent leurs phases preliminaires en meme temps
+    workerStates.assign(channels.size(), std::string());
+    for (size_t w = 0; w < channels.size(); ++w) {
+        receiveState(w);
+    }
+    mergeStates(workerStates);
+}
+
+void MonteCarloMethod::sampleWorkers(uint64_t step) {
+    uint64_t numWorkers = channels.size();
+    uint64_t numBefore = numGen;
+
+    // parts egales (a une generation pres), calculees en meme temps par les processus
+    for (uint64_t w = 0; w < numWorkers; ++w) {
+        uint64_t share = step / numWorkers + (w < step % numWorkers ? 1 : 0);
+        if (share > 0) {
+            StateWriter message;
+            message.writeUInt(share);
+            channels[w]->send(STEP_MESSAGE, message.data());
+        }
+    }
+    for (uint64_t w = 0; w < numWorkers && w < step; ++w) {
+        receiveState(w);
+    }
+
+    // fusion dans l'ordre des processus: le resultat est independant de l'ordre des reponses
+    mergeStates(workerStates);
+
+    if (telemetry && numGen > numBefore) {
+        telemetry->addEvaluations((antithetic ? 2 : 1) * (numGen - numBefore));
+    }
+}
+
+void MonteCarloMethod::receiveState(size_t worker) {
+    std::string content;
+    char type = channels[worker]->receive(content);
+
+    if (type == ERROR_MESSAGE) {
+        throw std::runtime_error("Processus de calcul " + std::to_string(worker) + ": " + content);
+    }
+    if (type != STATE_MESSAGE) {
+        throw std::runtime_error("Message du processus de calcul " + std::to_string(worker) + " invalide.");
+    }
+    workerStates[worker] = std::move(content);
+}
+
+void MonteCarloMethod::stopWorkers() {
+    for (std::unique_ptr<WorkerChannel>& channel : channels) {
+        try {
+            channel->send(END_MESSAGE, std::string());
+        } catch (const std::runtime_error&) {
+            // processus deja arrete
+        }
+    }
+    channels.clear();
+    workerStates.clear();
+}
+
+void MonteCarloMethod::serveSampling(WorkerChannel& channel) {
+    while (true) {
+        std::string content;
+        char type = channel.receive(content);
+        if (type == END_MESSAGE) {
+            return;
+        }
+
+        // les erreurs de la methode sont renvoyees au coordinateur, qui arrete l'echantillonnage
+        StateWriter state;
+        try {
+            StateReader in(content);
+            if (type == START_MESSAGE) {
+                uint64_t index = in.readUInt();
+                uint64_t keySize = in.readUInt();
+                std::vector<uint32_t> key;
+                for (uint64_t i = 0; i < keySize; ++i) {
+                    key.push_back((uint32_t)in.readUInt());
+                }
+
+                std::vector<uint32_t> params = workerSeedParams(key, index);
+                std::seed_seq seed(params.begin(), params.end());
+                setSeed(seed);
+                prepare();
+            } else if (type == STEP_MESSAGE) {
+                sample(in.readUInt());
+            } else {
+                throw std::runtime_error("Message du coordinateur invalide.");
+            }
+            saveState(state);
+        } catch (const std::exception& e) {
+            channel.send(ERROR_MESSAGE, e.what());
+            continue;
+        }
+        channel.send(STATE_MESSAGE, state.data());
+    }
+}
+
+void MonteCarloMethod::detachWorker() {
+    // les connexions du coordinateur aux processus crees avant celui-ci sont fermees (sans les attendre)
+    channels.clear();
+    numProcesses = 0;
+    remoteWorkers.clear();
+
+    // les threads du pool n'ont pas ete copies par fork: l'objet est abandonne (le detruire attendrait ses threads)
+    if (pool) {
+        unsigned numThreads = pool->size();
+        pool.release();
+        pool.reset(new ThreadPool(numThreads));
+    }
+
+    setTelemetry(nullptr);
 }
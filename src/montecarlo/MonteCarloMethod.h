@@ -3,31 +3,97 @@
 
 #include <random>
 #include <functional>
-#include <ctime>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <limits>
+#include <string>
 #include <cstdint>
 
+#include "Integrand.h"
+#include "../generators/RandomEngine.h"
+#include "../generators/ScrambledSobol.h"
 #include "../utility/Stats.h"
+#include "../utility/Accumulator.h"
+#include "../utility/ThreadPool.h"
+#include "../utility/Telemetry.h"
+#include "../utility/SamplingState.h"
+
+class CountedIntegrand;
+class WorkerChannel;
 
 /**
  * Represente une methode de Monte-Carlo (dans notre cas, utilisee afin de calculer une integrale en estimant son aire).
+ *
+ * Deux modes d'execution sont disponibles:
+ * - le mode sequentiel (par defaut): toutes les valeurs sont generees a la suite avec un unique generateur;
+ * - le mode parallele (voir setNumThreads): chaque etape d'echantillonnage est decoupee en "shards" de taille fixe,
+ *   chacun ayant son propre flux aleatoire (derive de la graine et de l'indice du shard) et son propre accumulateur.
+ *   Les accumulateurs sont fusionnes dans l'ordre des shards: le resultat ne depend donc pas du nombre de threads
+ *   utilises.
+ *
+ * Les methodes qui le permettent (voir supportsQuasiRandom) peuvent egalement utiliser le mode quasi-Monte Carlo
+ * randomise (voir setQuasiRandom): R replicats independants de la suite de Sobol brouillee sont parcourus en
+ * parallele, et l'IC est construit a partir des R estimations obtenues.
+ *
+ * Les methodes qui le permettent (voir supportsAntithetic) peuvent egalement utiliser des variables antithetiques
+ * (voir setAntithetic): chaque valeur de l'echantillon est alors la moyenne d'une paire d'evaluations de g.
+ *
+ * Enfin, le mode reparti (voir setNumProcesses et setRemoteWorkers) repartit chaque etape entre des processus de
+ * calcul ayant chacun une copie de la methode et son propre flux aleatoire. Les processus renvoient l'etat
+ * fusionnable de leur echantillon (voir saveState), que le coordinateur fusionne (voir mergeStates) afin d'obtenir
+ * l'aire estimee et l'IC de l'echantillon complet: les contraintes d'arret (taille, largeur de l'IC, temps)
+ * s'appliquent a l'ensemble des processus.
  */
 class MonteCarloMethod {
 public:
     // une fonction prenant un double et retournant un double
     typedef std::function<double(double)> Func;
 
+    // une fonction evaluee par lots: ecrit dans y[i] la valeur en x[i] pour i < n (voir BatchIntegrand)
+    typedef std::function<void(const double* x, double* y, size_t n)> BatchFunc;
+
 protected:
-    const Func& g;      // la fonciton dont on veut estimer l'aire
+    typedef std::chrono::steady_clock Clock;
+
+    // tache generant des valeurs: indice du bloc, generateur a utiliser et nombre de valeurs (voir runBlocks)
+    typedef std::function<void(uint64_t, RandomEngine&, uint64_t)> BlockTask;
+
+    std::unique_ptr<const Integrand> g; // la fonciton dont on veut estimer l'aire
+
+    RandomEngine mtGenerator;       // generateur utilise en mode sequentiel
+    std::vector<uint32_t> seedKey;  // parametres de la graine, utilises pour deriver les flux des shards
 
     double mean;        // la moyenne des valeurs generees
     double stdDev;      // l'estimateur de l'ecart-type de l'estimateur de l'aire
     double halfWidth;   // la demi-largeur de l'IC pour l'estimateur de l'aire
 
-    double sum;         // la somme des valeurs
-    double sumSquares;  // la somme des carres des valeurs
+    Accumulator values; // moyenne et variance des valeurs generees (voir Accumulator)
     uint64_t numGen;      // la taille de l'echantillon (nombre de valeurs generees)
 
-    clock_t start;      // utile pour la mesure du temps requis pour generer un echantillon
+    bool antithetic = false; // si chaque valeur est la moyenne d'une paire antithetique (voir setAntithetic)
+
+    Clock::time_point start;  // utile pour la mesure du temps requis pour generer un echantillon
+
+private:
+    std::unique_ptr<ThreadPool> pool; // threads du mode parallele (nul en mode sequentiel)
+    uint64_t shardSize = 1 << 14;     // nombre de valeurs generees par shard
+    uint64_t nextShard = 0;           // indice du prochain shard (et donc du prochain flux) a utiliser
+
+    double deadlineTolerance = 0.01;  // depassement tolere de l'echeance, en fraction du temps minimum
+
+    Telemetry* telemetry = nullptr;   // compteurs consultables pendant l'echantillonnage (voir setTelemetry)
+    CountedIntegrand* counted = nullptr; // enveloppe de g comptant les evaluations (creee par setTelemetry)
+
+    unsigned numProcesses = 0;                 // processus fils crees a chaque echantillonnage (mode reparti)
+    std::vector<std::string> remoteWorkers;    // sockets des processus de calcul independants (mode reparti)
+    std::vector<std::unique_ptr<WorkerChannel>> channels; // connexions aux processus de l'echantillonnage en cours
+    std::vector<std::string> workerStates;     // dernier etat recu de chaque processus
+    uint64_t nextWorker = 0;                   // indice du prochain flux de processus a utiliser
+
+    std::vector<ScrambledSobol> sequences;   // un replicat brouille par suite en mode quasi-Monte Carlo (vide sinon)
+    std::vector<Accumulator> replicates;     // valeurs de chaque replicat
+    uint64_t pointsPerReplicate;             // nombre de points deja utilises dans chaque replicat
 
 public:
     /**
@@ -37,8 +103,9 @@ public:
         double areaEstimator;                   // aire estimee
         double stdDevEstimator;                 // estimateur de l'ecart-type de l'aire estimee
         ConfidenceInterval confidenceInterval;  // intervalle de confiance a 95%
-        uint64_t N;                               // taille de l'echantillon
+        uint64_t N;                               // taille de l'echantillon (nombre de paires en mode antithetique)
         double elapsedTime;                     // temps pour creer la totalite de l'echantillon
+        uint64_t numEvaluations;                  // nombre d'evaluations de la fonction dont on estime l'aire
     };
 
     /*
@@ -46,19 +113,111 @@ public:
      *
      * @param g La fonction dont on veut estimer l'aire.
      */
-    MonteCarloMethod(const Func& g);
+    MonteCarloMethod(std::unique_ptr<const Integrand> g);
+
+    /**
+     * Ferme les connexions aux processus de calcul, s'il en reste (echantillonnage interrompu par une exception).
+     */
+    virtual ~MonteCarloMethod();
+
+    /**
+     * Initialise la graine du generateur utilise pour la methode (ainsi que celle des flux du mode parallele).
+     */
+    virtual void setSeed(const std::seed_seq& seed);
+
+    /**
+     * Choisit l'algorithme des generateurs de nombres pseudo-aleatoires (generateur du mode sequentiel et flux des
+     * shards et des strates). La graine deja donnee (voir setSeed) est conservee.
+     *
+     * @param kind L'algorithme a utiliser (std::mt19937_64 par defaut).
+     */
+    void setEngine(RandomEngine::Kind kind);
 
     /**
-     * Initialise la graine du generateur utilise pour la methode.
+     * Choisit le mode d'execution.
+     *
+     * @param numThreads 0 pour le mode sequentiel, sinon le nombre de threads du mode parallele.
+     */
+    void setNumThreads(unsigned numThreads);
+
+    /**
+     * Fixe le nombre de valeurs generees par shard en mode parallele. Le resultat depend de cette taille (mais pas
+     * du nombre de threads).
+     *
+     * @param size La taille d'un shard (au moins 1).
      */
-    virtual void setSeed(const std::seed_seq& seed) = 0;
+    void setShardSize(uint64_t size);
+
+    /**
+     * Active le mode quasi-Monte Carlo randomise. A chaque etape, step / R points (au moins 1) sont ajoutes a chaque
+     * replicat: des tailles d'echantillon multiples de R fois une puissance de 2 sont preferables.
+     *
+     * @param numReplicates Le nombre R de replicats (au moins 2), ou 0 pour revenir au mode pseudo-aleatoire.
+     * @throw std::invalid_argument Si la methode ne supporte pas ce mode.
+     */
+    void setQuasiRandom(unsigned numReplicates);
+
+    /**
+     * Active le mode antithetique: chaque valeur de l'echantillon est la moyenne des valeurs obtenues en X et en
+     * a + b - X, avec X ~ U(a,b). Une seule uniforme est tiree par paire, et la variance diminue fortement lorsque g
+     * est monotone. La taille de l'echantillon (et l'ecart-type de l'estimateur) porte sur les paires: le nombre
+     * d'evaluations de g est le double (voir Sampling::numEvaluations).
+     *
+     * @param enabled Si le mode doit etre active.
+     * @throw std::invalid_argument Si la methode ne supporte pas ce mode.
+     */
+    void setAntithetic(bool enabled);
+
+    /**
+     * Attache des compteurs a la methode: les evaluations de la fonction sont comptees lot par lot, par chaque
+     * thread, et la taille de l'echantillon, l'aire estimee et la demi-largeur de l'IC sont publiees a la fin de
+     * chaque etape d'echantillonnage (voir Telemetry).
+     *
+     * @param telemetry Les compteurs (qui doivent rester valides pendant les echantillonnages), ou nullptr.
+     */
+    void setTelemetry(Telemetry* telemetry);
+
+    /**
+     * Active le mode reparti avec des processus locaux: au debut de chaque echantillonnage, numProcesses processus
+     * fils sont crees (fork) avec une copie de la methode dans son etat courant, et ils se terminent a la fin de
+     * l'echantillonnage. Chaque processus utilise son propre flux aleatoire (derive de la graine et d'un indice de
+     * processus) et le mode d'execution de la methode (ex: setNumThreads). Le resultat depend donc du nombre de
+     * processus. Les processus fils ne mettent pas a jour les compteurs (voir setTelemetry): le coordinateur y publie
+     * l'echantillon complet.
+     *
+     * Disponible uniquement sur les systemes POSIX.
+     *
+     * @param numProcesses Le nombre de processus fils, ou 0 pour ne pas en creer.
+     */
+    void setNumProcesses(unsigned numProcesses);
+
+    /**
+     * Ajoute au mode reparti des processus de calcul independants (ex: sur d'autres noeuds, relies par des sockets
+     * Unix), qui executent serveWorker avec une methode configuree de la meme facon (fonction, points, mode, etc). La
+     * graine et l'indice de flux de chaque processus sont envoyes par le coordinateur. Un processus local executant
+     * serveWorker peut remplacer un noeud distant (ex: pour les tests).
+     *
+     * @param socketPaths Les chemins des sockets Unix des processus (vide pour n'utiliser que des processus fils).
+     */
+    void setRemoteWorkers(const std::vector<std::string>& socketPaths);
+
+    /**
+     * Execute le processus de calcul du mode reparti: attend les connexions des coordinateurs sur une socket Unix et
+     * effectue les etapes d'echantillonnage demandees avec cette methode, un echantillonnage par connexion. Les
+     * erreurs d'echantillonnage sont renvoyees au coordinateur. Ne retourne pas: le processus est arrete par un
+     * signal.
+     *
+     * @param socketPath Le chemin de la socket (remplace le fichier existant, s'il y en a un).
+     * @throw std::runtime_error Si la socket ne peut pas etre creee.
+     */
+    void serveWorker(const std::string& socketPath);
 
     /**
      * Genere un echantillon d'une taille donnee.
      *
      * @pram N la taille totale de l'echantillon.
      */
-    virtual Sampling sampleWithSize(uint64_t N) = 0;
+    virtual Sampling sampleWithSize(uint64_t N);
 
     /**
      * Genere autant de valeurs que necessaire afin d'obtenir un intervalle de confiance a 95% pour l'aire estimee
@@ -67,7 +226,22 @@ public:
      * @param maxWidth La taille maximale que doit avoir l'IC.
      * @param step Le nombre de generations qui seront effectuees avant de reverifier la taille de l'IC.
      */
-    virtual Sampling sampleWithMaxWidth(double maxWidth, uint64_t step) = 0;
+    virtual Sampling sampleWithMaxWidth(double maxWidth, uint64_t step);
+
+    /**
+     * Equivalent de sampleWithMaxWidth sans nombre de generations fixe par etape (arret sequentiel predictif): apres
+     * une phase pilote, la variance courante est utilisee pour predire le nombre de valeurs encore necessaires, dont
+     * la plus grande partie est generee d'un coup avant d'affiner la prediction. Peu de verifications sont donc
+     * necessaires et le depassement final est d'au plus un lot.
+     *
+     * Afin que l'arret reste valide (la variance peut etre sous-estimee par hasard sur un petit echantillon),
+     * l'arret n'est possible qu'apres la phase pilote et la variance par valeur utilisee est majoree de 1/n (regle
+     * de Chow-Robbins), soit scale()^2 / n^2 pour la variance de l'aire estimee.
+     *
+     * @param maxWidth La taille maximale que doit avoir l'IC.
+     * @throw std::invalid_argument Si maxWidth n'est pas strictement positive.
+     */
+    virtual Sampling sampleWithMaxWidth(double maxWidth);
 
     /**
      * Genere un intervalle de confiance a 95% pour l'aire estimee aussi precise que possible en generant des valeurs
@@ -76,13 +250,239 @@ public:
      * @param minTime Le temps minimum qui doit etre utilise pour affiner la precision de l'IC.
      * @pram step Le nombre de generations qui seront effectuees avant de reverifier le temps d'execution total.
      */
-    virtual Sampling sampleWithMinTime(double minTime, uint64_t step) = 0;
+    virtual Sampling sampleWithMinTime(double minTime, uint64_t step);
+
+    /**
+     * Genere des valeurs jusqu'a une echeance (temps reel, mesure depuis le debut de l'echantillonnage, phase
+     * preliminaire comprise) sans nombre de generations fixe par etape: le cout d'une generation est mesure au fur et
+     * a mesure et la taille de chaque etape est choisie afin que:
+     * - le depassement de l'echeance reste inferieur a la tolerance (voir setDeadlineTolerance);
+     * - chaque etape dure au moins 100 fois le temps d'une verification (surcout inferieur a 1%);
+     * - la limite dure maxTime ne soit pas depassee, meme si une etape dure deux fois plus longtemps que prevu.
+     * La premiere etape ne genere qu'une valeur (sonde du cout), les suivantes au plus 8 fois plus que la precedente.
+     * La phase preliminaire n'est pas interruptible: sa duree compte dans le temps et la limite dure est verifiee
+     * juste apres, avant toute etape.
+     *
+     * @param minTime Le temps minimum qui doit etre utilise pour affiner la precision de l'IC.
+     * @param maxTime Le temps maximum (limite dure): l'echantillonnage s'arrete avant minTime si necessaire.
+     * @throw std::invalid_argument Si minTime est negatif ou plus grand que maxTime.
+     */
+    virtual Sampling sampleWithDeadline(double minTime,
+                                        double maxTime = std::numeric_limits<double>::infinity());
+
+    /**
+     * Fixe le depassement tolere de l'echeance en mode sampleWithDeadline. Une tolerance plus petite implique des
+     * etapes plus courtes (et donc plus de verifications).
+     *
+     * @param tolerance Le depassement tolere, en fraction du temps minimum (par defaut 0.01).
+     */
+    void setDeadlineTolerance(double tolerance);
 
 protected:
     /**
      * Initialise les differents champs. Doit etre appelee au debut de chaque etape d'echantillonage.
      */
     void init();
+
+    /**
+     * Prepare un echantillonnage. Par defaut, appelle simplement init. Les methodes ayant une phase preliminaire
+     * (ex: variable de controle) l'effectuent ici.
+     */
+    virtual void prepare();
+
+    /**
+     * Effectue un certain nombre de generations avec un generateur donne et ajoute les valeurs obtenues a un
+     * accumulateur donne (par lots, voir Accumulator::add). Peut etre appelee simultanement depuis plusieurs threads
+     * (avec des generateurs et des accumulateurs differents).
+     *
+     * @param engine Le generateur a utiliser.
+     * @param n Le nombre de generations a effectuer.
+     * @param acc L'accumulateur a mettre a jour.
+     */
+    virtual void sampleBlock(RandomEngine& engine, uint64_t n, Accumulator& acc) const = 0;
+
+    /**
+     * @return Le facteur tel que l'aire estimee vaut scale() * mean.
+     */
+    virtual double scale() const = 0;
+
+    /**
+     * @return Si la methode supporte le mode quasi-Monte Carlo randomise (voir sampleQuasiBlock).
+     */
+    virtual bool supportsQuasiRandom() const;
+
+    /**
+     * @return Si la methode supporte le mode antithetique (voir setAntithetic). Par defaut, non.
+     */
+    virtual bool supportsAntithetic() const;
+
+    /**
+     * @return Si le mode quasi-Monte Carlo randomise est active (voir setQuasiRandom).
+     */
+    bool isQuasiRandom() const;
+
+    /**
+     * Equivalent de sampleBlock pour le mode quasi-Monte Carlo randomise: utilise des points consecutifs d'une suite
+     * brouillee plutot qu'un generateur. Par defaut, leve une exception (mode non supporte).
+     *
+     * @param sequence La suite brouillee (replicat) a utiliser.
+     * @param first L'indice du premier point de la suite a utiliser.
+     * @param n Le nombre de points a utiliser.
+     * @param acc L'accumulateur a mettre a jour.
+     */
+    virtual void sampleQuasiBlock(const ScrambledSobol& sequence, uint64_t first, uint64_t n, Accumulator& acc) const;
+
+    /**
+     * Ecrit l'etat fusionnable de l'echantillon courant (mode reparti): les accumulateurs a partir desquels les
+     * statistiques sont calculees. Par defaut, l'accumulateur des valeurs, ou celui de chaque replicat en mode
+     * quasi-Monte Carlo. Les methodes dont l'estimateur n'est pas une simple moyenne des valeurs la redefinissent
+     * (avec mergeStates).
+     *
+     * @param out L'etat.
+     */
+    virtual void saveState(StateWriter& out) const;
+
+    /**
+     * Remplace l'echantillon par la reunion d'echantillons independants (etats ecrits par saveState avec la meme
+     * configuration, chacun avec son propre flux aleatoire) et met a jour les statistiques. Par defaut, fusionne les
+     * accumulateurs des valeurs; en mode quasi-Monte Carlo, les replicats de tous les etats forment les replicats de
+     * l'echantillon.
+     *
+     * @param states Les etats, dans l'ordre des processus.
+     * @throw std::runtime_error Si un etat est incompatible.
+     */
+    virtual void mergeStates(const std::vector<std::string>& states);
+
+    /**
+     * Effectue un certain nombre donne de generations afin de mettre a jour les statistiques (moyenne, variance, etc)
+     * et de creer un IC pour l'aire estimee. Les methodes dont l'estimateur n'est pas une simple moyenne des valeurs
+     * (ex: echantillonnage stratifie) la redefinissent.
+     *
+     * @param step Le nombre de generation qui seront effectuees.
+     */
+    virtual void sample(uint64_t step);
+
+    /**
+     * @param n Un nombre de generations.
+     * @return Le nombre de blocs entre lesquels runBlocks repartit ces generations.
+     */
+    uint64_t numBlocks(uint64_t n) const;
+
+    /**
+     * Repartit des generations en blocs, comme une etape d'echantillonnage: un unique bloc utilisant le generateur
+     * du mode sequentiel, ou un bloc par shard (avec son propre flux) en mode parallele. Permet aux methodes de
+     * generer en parallele d'autres statistiques que les valeurs (ex: phase preliminaire).
+     *
+     * @param n Le nombre de generations.
+     * @param task La tache a executer pour chaque bloc (voir numBlocks).
+     */
+    void runBlocks(uint64_t n, const BlockTask& task);
+
+    /**
+     * Execute des taches independantes: en parallele en mode parallele, a la suite sinon.
+     *
+     * @param numTasks Le nombre de taches.
+     * @param task La tache a executer pour chaque indice.
+     */
+    void forEachTask(uint64_t numTasks, const ThreadPool::Task& task);
+
+    /**
+     * Met a jour la moyenne, l'ecart-type et la demi-largeur de l'IC a partir de l'accumulateur.
+     */
+    void updateStatistics();
+
+    /**
+     * Empaquete toutes les valeurs associees a l'echantillon (aire estimee, IC, etc: voir MonteCarloMethod::Sampling).
+     *
+     * @param timeElapsed Le temps utilise pour creer l'echantillon.
+     * @return L'echantillon cree.
+     */
+    virtual Sampling createSampling(double timeElapsed) const;
+
+    /**
+     * @return Le temps ecoule (en secondes) depuis le dernier appel a init.
+     */
+    double elapsedTime() const;
+
+private:
+    /**
+     * Prepare un echantillonnage (voir prepare), ou lance les processus de calcul en mode reparti.
+     */
+    void begin();
+
+    /**
+     * Termine un echantillonnage: arrete les processus de calcul, s'il y en a.
+     *
+     * @param timeElapsed Le temps utilise pour creer l'echantillon.
+     * @return L'echantillon cree (voir createSampling).
+     */
+    Sampling finish(double timeElapsed);
+
+    /**
+     * Effectue une etape d'echantillonnage (voir sample, ou sampleWorkers en mode reparti) et publie les statistiques
+     * dans les compteurs, s'il y en a.
+     *
+     * @param step Le nombre de generation qui seront effectuees.
+     */
+    void runStep(uint64_t step);
+
+    /**
+     * Cree les processus fils, se connecte aux processus independants et leur fait preparer l'echantillonnage, chacun
+     * avec son propre flux.
+     */
+    void startWorkers();
+
+    /**
+     * Repartit les generations d'une etape entre les processus de calcul et fusionne leurs etats.
+     *
+     * @param step Le nombre de generation qui seront effectuees.
+     */
+    void sampleWorkers(uint64_t step);
+
+    /**
+     * Attend l'etat d'un processus de calcul.
+     *
+     * @param worker L'indice du processus.
+     * @throw std::runtime_error Si le processus a renvoye une erreur ou si la connexion est fermee.
+     */
+    void receiveState(size_t worker);
+
+    /**
+     * Termine les processus de calcul de l'echantillonnage en cours.
+     */
+    void stopWorkers();
+
+    /**
+     * Traite les messages d'un coordinateur (cote processus de calcul) jusqu'a la fin de l'echantillonnage.
+     *
+     * @param channel La connexion au coordinateur.
+     */
+    void serveSampling(WorkerChannel& channel);
+
+    /**
+     * Prepare la copie de la methode d'un processus fils: les threads du mode parallele et les connexions aux autres
+     * processus n'existent pas dans le fils, et les compteurs ne sont mis a jour que par le coordinateur.
+     */
+    void detachWorker();
+
+    /**
+     * Effectue les generations d'une etape en mode parallele, shard par shard.
+     *
+     * @param step Le nombre de generation qui seront effectuees.
+     */
+    void sampleShards(uint64_t step);
+
+    /**
+     * Effectue les generations d'une etape en mode quasi-Monte Carlo randomise, replicat par replicat.
+     *
+     * @param step Le nombre de generation qui seront effectuees (reparties entre les replicats).
+     */
+    void sampleReplicates(uint64_t step);
+
+    /**
+     * Met a jour la moyenne, l'ecart-type et la demi-largeur de l'IC a partir des estimations des replicats.
+     */
+    void updateReplicateStatistics();
 };
 
 #endif // MONTECARLOMETHOD_H
@@ -0,0 +1,201 @@
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "StratifiedSampling.h"
+#include "../utility/Profiler.h"
+
+// part minimale de chaque strate, relative a l'allocation proportionnelle L_h / (b - a): une strate dont la phase
+// pilote n'a vu qu'une fonction constante (ex: pic etroit manque) continue d'etre echantillonnee
+static const double MIN_PROPORTIONAL_SHARE = 0.1;
+
+StratifiedSampling::StratifiedSampling(const Func& g, const std::vector<double>& grid)
+        : StratifiedSampling(makeIntegrand(g), grid) {}
+
+StratifiedSampling::StratifiedSampling(std::unique_ptr<const Integrand> g, const std::vector<double>& grid)
+        : MonteCarloMethod(std::move(g))
+{
+    if (grid.size() < 2) {
+        throw std::invalid_argument("Il faut au moins 2 points pour definir une strate.");
+    }
+
+    strata.resize(grid.size() - 1);
+    for (size_t h = 0; h < strata.size(); ++h) {
+        if (grid[h + 1] <= grid[h]) {
+            throw std::invalid_argument("Les bornes des strates doivent etre strictement croissantes.");
+        }
+        strata[h].x0 = grid[h];
+        strata[h].width = grid[h + 1] - grid[h];
+    }
+
+    a = grid.front();
+    b = grid.back();
+}
+
+void StratifiedSampling::setSeed(const std::seed_seq& seed) {
+    MonteCarloMethod::setSeed(seed);
+    nextStream = 0;
+}
+
+void StratifiedSampling::setPilotSize(uint64_t size) {
+    if (size < 2) {
+        throw std::invalid_argument("La phase pilote doit generer au moins 2 valeurs par strate.");
+    }
+    pilotSize = size;
+}
+
+void StratifiedSampling::prepare() {
+    init();
+
+    // nouveaux flux a chaque echantillonnage (comme le generateur du mode sequentiel, ils dependent de la graine)
+    for (Stratum& stratum : strata) {
+        stratum.engine = RandomEngine(mtGenerator.getKind());
+        seedStream(stratum.engine, seedKey, nextStream++);
+        stratum.values = Accumulator();
+        stratum.step = pilotSize;
+    }
+
+    // phase pilote: meme nombre de valeurs dans chaque strate, afin d'estimer leurs ecarts-types
+    forEachTask(strata.size(), [this](uint64_t h) {
+        sampleStratum(strata[h], strata[h].step);
+    });
+
+    numGen = pilotSize * strata.size();
+    updateStratifiedStatistics();
+}
+
+void StratifiedSampling::sample(uint64_t step) {
+    allocate(step);
+
+    forEachTask(strata.size(), [this](uint64_t h) {
+        sampleStratum(strata[h], strata[h].step);
+    });
+
+    numGen += step;
+    updateStratifiedStatistics();
+}
+
+void StratifiedSampling::saveState(StateWriter& out) const {
+    out.writeUInt(strata.size());
+    for (const Stratum& stratum : strata) {
+        out.writeAccumulator(stratum.values);
+    }
+}
+
+void StratifiedSampling::mergeStates(const std::vector<std::string>& states) {
+    for (Stratum& stratum : strata) {
+        stratum.values = Accumulator();
+    }
+
+    for (const std::string& state : states) {
+        StateReader in(state);
+        if (in.readUInt() != strata.size()) {
+            throw std::runtime_error("Etat d'echantillonnage incompatible: nombre de strates different.");
+        }
+        for (Stratum& stratum : strata) {
+            stratum.values.merge(in.readAccumulator());
+        }
+        if (!in.atEnd()) {
+            throw std::runtime_error("Etat d'echantillonnage incompatible.");
+        }
+    }
+
+    numGen = 0;
+    for (const Stratum& stratum : strata) {
+        numGen += stratum.values.count();
+    }
+    updateStratifiedStatistics();
+}
+
+void StratifiedSampling::sampleBlock(RandomEngine&, uint64_t, Accumulator&) const {
+    throw std::logic_error("L'echantillonnage stratifie genere les valeurs strate par strate.");
+}
+
+double StratifiedSampling::scale() const {
+    return b - a;
+}
+
+void StratifiedSampling::sampleStratum(Stratum& stratum, uint64_t n) const {
+    double xs[BATCH_SIZE], ys[BATCH_SIZE];
+
+    for (uint64_t done = 0; done < n; done += BATCH_SIZE) {
+        size_t m = (size_t)std::min<uint64_t>(BATCH_SIZE, n - done);
+        SIO_PROFILE_BATCH(m);
+
+        fillUniform(stratum.engine, xs, m);
+        SIO_PROFILE_MARK(UNIFORM);
+        for (size_t i = 0; i < m; ++i) {
+            xs[i] = xs[i] * stratum.width + stratum.x0; // X ~ U(x_h, x_h+1)
+        }
+        SIO_PROFILE_MARK(TRANSFORM);
+
+        g->evaluate(xs, ys, m);
+        SIO_PROFILE_MARK(INTEGRAND);
+
+        stratum.values.add(ys, m);
+        SIO_PROFILE_MARK(ACCUMULATE);
+    }
+}
+
+void StratifiedSampling::allocate(uint64_t step) {
+    size_t numStrata = strata.size();
+
+    // allocation de Neyman: poids L_h * sigma_h (largeurs si toutes les strates semblent constantes)
+    std::vector<double> weights(numStrata);
+    double neymanTotal = 0;
+    for (size_t h = 0; h < numStrata; ++h) {
+        weights[h] = strata[h].width * sqrt(strata[h].values.variance());
+        neymanTotal += weights[h];
+    }
+
+    // melange avec l'allocation proportionnelle: chaque strate recoit au moins MIN_PROPORTIONAL_SHARE de sa part
+    // proportionnelle, meme si son ecart-type estime est nul
+    double neymanShare = neymanTotal > 0 ? 1 - MIN_PROPORTIONAL_SHARE : 0;
+    double totalWeight = 1;
+    for (size_t h = 0; h < numStrata; ++h) {
+        double proportional = strata[h].width / (b - a);
+        double neyman = neymanTotal > 0 ? weights[h] / neymanTotal : 0;
+        weights[h] = neymanShare * neyman + (1 - neymanShare) * proportional;
+    }
+
+    // l'etape comble le retard de chaque strate sur la taille visee pour l'echantillon complet
+    double total = (double)(numGen + step);
+    std::vector<double> deficits(numStrata);
+    double totalDeficit = 0;
+    for (size_t h = 0; h < numStrata; ++h) {
+        double target = total * weights[h] / totalWeight;
+        deficits[h] = std::max(0.0, target - strata[h].values.count());
+        totalDeficit += deficits[h];
+    }
+    if (totalDeficit <= 0) {
+        deficits = weights;
+        totalDeficit = totalWeight;
+    }
+
+    // arrondi des parts cumulees: la somme des tailles vaut exactement step
+    double cumulated = 0;
+    uint64_t allocated = 0;
+    for (size_t h = 0; h < numStrata; ++h) {
+        cumulated += deficits[h];
+        uint64_t upTo = h + 1 == numStrata ? step : std::min(step, (uint64_t)(step * (cumulated / totalDeficit)));
+        strata[h].step = upTo - allocated;
+        allocated = upTo;
+    }
+}
+
+void StratifiedSampling::updateStratifiedStatistics() {
+    // aire estimee: somme des L_h * moyenne_h, variance: somme des L_h^2 * variance_h / n_h
+    double area = 0, var = 0;
+    for (const Stratum& stratum : strata) {
+        uint64_t n = stratum.values.count();
+        if (n == 0) {
+            continue;
+        }
+        area += stratum.width * stratum.values.mean();
+        var += stratum.width * stratum.width * stratum.values.variance() / n;
+    }
+
+    mean = area / scale();
+    stdDev = sqrt(var);
+    halfWidth = 1.96 * stdDev;
+}
@@ -0,0 +1,137 @@
+#ifndef STRATIFIED_SAMPLING_H
+#define STRATIFIED_SAMPLING_H
+
+#include "MonteCarloMethod.h"
+
+/**
+ * Represente la methode d'integration par echantillonnage stratifie: l'intervalle [a,b] est decoupe en strates
+ * (ex: les morceaux de la fonction affine par morceaux, ou une grille donnee) dans lesquelles on echantillonne
+ * uniformement et independamment. L'aire estimee est la somme des aires estimees dans chaque strate.
+ *
+ * Apres une phase pilote (quelques valeurs par strate), les valeurs de chaque etape sont reparties entre les strates
+ * selon l'allocation de Neyman: la taille de l'echantillon de la strate h est proportionnelle a L_h * sigma_h, avec
+ * L_h sa largeur et sigma_h l'ecart-type estime de g dans la strate (mis a jour a chaque etape). Chaque strate recoit
+ * cependant au moins 10% de sa part proportionnelle L_h / (b - a): une strate ou g semblait constante lors de la
+ * phase pilote (ex: pic etroit manque par ses quelques valeurs) continue d'etre echantillonnee, de sorte que le pic
+ * peut encore etre trouve et que l'estimation et l'IC ne restent pas biaises.
+ *
+ * Chaque strate a son propre flux aleatoire (derive de la graine): les strates sont echantillonnees en parallele en
+ * mode parallele (voir setNumThreads), et le resultat ne depend pas du nombre de threads.
+ */
+class StratifiedSampling : public MonteCarloMethod {
+private:
+    /**
+     * Etat d'une strate.
+     */
+    struct Stratum {
+        double x0, width;     // borne inferieure et largeur de la strate
+        RandomEngine engine;  // flux aleatoire propre a la strate
+        Accumulator values;   // valeurs generees dans la strate
+        uint64_t step;        // nombre de valeurs a generer lors de l'etape en cours
+    };
+
+    std::vector<Stratum> strata;
+    double a, b;               // bornes inferieure et superieure de l'intervalle sur lequel on veut evaluer la fonction
+
+    uint64_t pilotSize = 100;  // nombre de valeurs generees par strate lors de la phase pilote
+    uint64_t nextStream = 0;   // indice du prochain flux a utiliser (un par strate et par echantillonnage)
+
+public:
+    /**
+     * Prepare la methode.
+     *
+     * @param g La fonction dont on veut estimer l'aire.
+     * @param grid Les bornes des strates, croissantes (ex: les abscisses des points d'une fonction affine par
+     * morceaux). L'aire est estimee entre grid.front() et grid.back().
+     * @throw std::invalid_argument Si la grille contient moins de 2 points ou n'est pas strictement croissante.
+     */
+    StratifiedSampling(const Func& g, const std::vector<double>& grid);
+
+    /**
+     * Prepare la methode avec une fonction dont le type est connu a la compilation (ex: lambda): les appels a g dans
+     * la boucle d'echantillonnage sont alors mis en ligne. Une fonction de signature
+     * void(const double*, double*, size_t) (voir BatchFunc) est evaluee directement sur les lots de points generes.
+     *
+     * @see StratifiedSampling(const Func&, const std::vector<double>&).
+     */
+    template <typename G>
+    StratifiedSampling(G g, const std::vector<double>& grid)
+            : StratifiedSampling(makeIntegrand(std::move(g)), grid) {}
+
+    /**
+     * @see StratifiedSampling(const Func&, const std::vector<double>&).
+     */
+    StratifiedSampling(std::unique_ptr<const Integrand> g, const std::vector<double>& grid);
+
+    /**
+     * @see MonteCarloMethod::setSeed.
+     */
+    void setSeed(const std::seed_seq& seed);
+
+    /**
+     * Fixe le nombre de valeurs generees par strate lors de la phase pilote.
+     *
+     * @param size Le nombre de valeurs par strate (au moins 2, afin d'estimer l'ecart-type de chaque strate).
+     */
+    void setPilotSize(uint64_t size);
+
+protected:
+    /**
+     * Effectue la phase pilote.
+     */
+    void prepare();
+
+    /**
+     * Repartit les generations entre les strates (allocation de Neyman) puis echantillonne les strates.
+     *
+     * @see MonteCarloMethod::sample.
+     */
+    void sample(uint64_t step);
+
+    /**
+     * @see MonteCarloMethod::saveState. L'etat contient l'accumulateur de chaque strate.
+     */
+    void saveState(StateWriter& out) const;
+
+    /**
+     * @see MonteCarloMethod::mergeStates. Les strates de meme indice sont fusionnees: chaque processus a reparti ses
+     * valeurs selon ses propres estimations des ecarts-types.
+     */
+    void mergeStates(const std::vector<std::string>& states);
+
+    /**
+     * Non utilisee: les valeurs sont generees strate par strate (voir sampleStratum).
+     *
+     * @throw std::logic_error Toujours.
+     */
+    void sampleBlock(RandomEngine& engine, uint64_t n, Accumulator& acc) const;
+
+    /**
+     * @see MonteCarloMethod::scale.
+     */
+    double scale() const;
+
+private:
+    /**
+     * Genere un certain nombre de valeurs dans une strate. Peut etre appelee simultanement depuis plusieurs threads
+     * (pour des strates differentes).
+     *
+     * @param stratum La strate.
+     * @param n Le nombre de valeurs a generer.
+     */
+    void sampleStratum(Stratum& stratum, uint64_t n) const;
+
+    /**
+     * Repartit un nombre de generations entre les strates (champ step).
+     *
+     * @param step Le nombre de generations a repartir.
+     */
+    void allocate(uint64_t step);
+
+    /**
+     * Met a jour la moyenne, l'ecart-type et la demi-largeur de l'IC a partir des valeurs des strates.
+     */
+    void updateStratifiedStatistics();
+};
+
+#endif // STRATIFIED_SAMPLING_H
@@ -1,71 +1,84 @@
-#include <ctime>
+#include <stdexcept>
+#include <algorithm>
 
-#include <vector>
 #include "UniformSampling.h"
+#include "../utility/Profiler.h"
 
 UniformSampling::UniformSampling(const MonteCarloMethod::Func& g, double a, double b)
-        :
-        MonteCarloMethod(g), a(a), b(b),
-        uniformDistr(std::uniform_real_distribution<double>(0, 1))
+        : UniformSampling(makeIntegrand(g), a, b) {}
+
+UniformSampling::UniformSampling(std::unique_ptr<const Integrand> g, double a, double b)
+        : MonteCarloMethod(std::move(g)), a(a), b(b)
 {
     if (b <= a) {
         throw std::invalid_argument("b doit etre plus grand que a");
     }
 }
 
-MonteCarloMethod::Sampling UniformSampling::sampleWithSize(uint64_t N) {
-    init();
+void UniformSampling::sampleBlock(RandomEngine& engine, uint64_t n, Accumulator& acc) const {
+    double us[BATCH_SIZE], ys[BATCH_SIZE];
 
-    sample(N);
-    return createSampling((double)(clock() - start) / CLOCKS_PER_SEC);
-}
+    for (uint64_t done = 0; done < n; done += BATCH_SIZE) {
+        size_t m = (size_t)std::min<uint64_t>(BATCH_SIZE, n - done);
+        SIO_PROFILE_BATCH(m);
 
-MonteCarloMethod::Sampling UniformSampling::sampleWithMaxWidth(double maxWidth, uint64_t step) {
-    init();
+        fillUniform(engine, us, m);
+        SIO_PROFILE_MARK(UNIFORM);
+        evaluatePoints(us, ys, m);
 
-    do {
-        sample(step);
-    } while (halfWidth * 2 > maxWidth);
+        acc.add(ys, m);
+        SIO_PROFILE_MARK(ACCUMULATE);
+    }
+}
 
-    return createSampling((double)(clock() - start) / CLOCKS_PER_SEC);
+double UniformSampling::scale() const {
+    return b - a;
 }
 
-MonteCarloMethod::Sampling UniformSampling::sampleWithMinTime(double maxTime, uint64_t step) {
-    init();
-    double curTime = 0;
+bool UniformSampling::supportsQuasiRandom() const {
+    return true;
+}
+
+void UniformSampling::sampleQuasiBlock(const ScrambledSobol& sequence, uint64_t first, uint64_t n,
+                                       Accumulator& acc) const {
+    double us[BATCH_SIZE], ys[BATCH_SIZE];
+
+    for (uint64_t done = 0; done < n; done += BATCH_SIZE) {
+        size_t m = (size_t)std::min<uint64_t>(BATCH_SIZE, n - done);
 
-    do {
-        clock_t beg = clock();
-        sample(step);
-        curTime += (double)(clock() - beg) / CLOCKS_PER_SEC;
-    } while (curTime < maxTime);
+        sequence.points(first + done, us, m);
+        evaluatePoints(us, ys, m);
 
-    return createSampling(curTime);
+        acc.add(ys, m);
+    }
 }
 
-void UniformSampling::setSeed(const std::seed_seq &seed) {
-    std::seed_seq copy = seed;
-    mtGenerator.seed(copy);
+bool UniformSampling::supportsAntithetic() const {
+    return true;
 }
 
-void UniformSampling::sample(uint64_t step) {
-    for (uint64_t i = 0; i < step; ++i) {
-        double X = uniformDistr(mtGenerator) * (b - a) + a; // X ~ U(a,b)
-        double Y = g(X);
+void UniformSampling::evaluatePoints(const double* us, double* values, size_t m) const {
+    double xs[2 * BATCH_SIZE], ys[2 * BATCH_SIZE];
 
-        sum += Y;
-        sumSquares += Y * Y;
+    for (size_t i = 0; i < m; ++i) {
+        xs[i] = us[i] * (b - a) + a; // X ~ U(a,b)
     }
+    SIO_PROFILE_MARK(TRANSFORM);
 
-    numGen += step;
+    if (!antithetic) {
+        g->evaluate(xs, values, m);
+        SIO_PROFILE_MARK(INTEGRAND);
+        return;
+    }
 
-    mean = sum / numGen;
-    double var = (sumSquares / numGen) - mean * mean;
-    stdDev = (b-a) * sqrt(var / numGen);
-    halfWidth = 1.96 * (b - a) * sqrt(var / numGen);
-}
+    // les points antithetiques a + b - X suivent les X dans le tampon: g est evaluee en un seul appel
+    for (size_t i = 0; i < m; ++i) {
+        xs[m + i] = a + b - xs[i];
+    }
+    g->evaluate(xs, ys, 2 * m);
+    SIO_PROFILE_MARK(INTEGRAND);
 
-MonteCarloMethod::Sampling UniformSampling::createSampling(double timeElapsed) const {
-    double areaEstimator = (b-a) * mean;
-    return {areaEstimator, stdDev, ConfidenceInterval(areaEstimator, halfWidth), numGen, timeElapsed};
-}
\ No newline at end of file
+    for (size_t i = 0; i < m; ++i) {
+        values[i] = (ys[i] + ys[m + i]) / 2;
+    }
+}
@@ -8,10 +8,6 @@
  */
 class UniformSampling : public MonteCarloMethod {
 private:
-    // generateur mersenne-twister et distribution uniforme
-    std::mt19937_64 mtGenerator;
-    std::uniform_real_distribution<double> uniformDistr;
-
     double a, b; // bornes inferieure et superieure de l'intervalle sur lequel on veut evaluer la fonction
 
 public:
@@ -24,40 +20,64 @@ public:
      */
     UniformSampling(const Func& g, double a, double b);
 
+    /*
+     * Prepare la methode avec une fonction dont le type est connu a la compilation (ex: lambda): les appels a g dans
+     * la boucle d'echantillonnage sont alors mis en ligne. Une fonction de signature
+     * void(const double*, double*, size_t) (voir BatchFunc) est evaluee directement sur les lots de points generes.
+     *
+     * @param g La fonction dont on veut estimer l'aire.
+     * @param a la borne inferieure de l'intervalle sur lequel on veut evaluer g.
+     * @param b la borne superieure de l'intervalle sur lequel on veut evaluer g.
+     */
+    template <typename G>
+    UniformSampling(G g, double a, double b) : UniformSampling(makeIntegrand(std::move(g)), a, b) {}
+
+    /*
+     * Prepare la methode.
+     *
+     * @param g La fonction dont on veut estimer l'aire.
+     * @param a la borne inferieure de l'intervalle sur lequel on veut evaluer g.
+     * @param b la borne superieure de l'intervalle sur lequel on veut evaluer g.
+     */
+    UniformSampling(std::unique_ptr<const Integrand> g, double a, double b);
 
+protected:
     /**
-     * @see MontecarloMethod::sampleWithSize.
+     * @see MonteCarloMethod::sampleBlock.
      */
-    Sampling sampleWithSize(uint64_t N);
+    void sampleBlock(RandomEngine& engine, uint64_t n, Accumulator& acc) const;
+
     /**
-     * @see MontecarloMethod::sampleWithMaxWidth.
+     * @see MonteCarloMethod::scale.
      */
-    Sampling sampleWithMaxWidth(double maxWidth, uint64_t step);
+    double scale() const;
+
     /**
-     * @see MontecarloMethod::sampleWithMinTime.
+     * @see MonteCarloMethod::supportsQuasiRandom.
      */
-    Sampling sampleWithMinTime(double maxTime, uint64_t step);
+    bool supportsQuasiRandom() const;
 
     /**
-     * @see MonteCarloMethod::setSeed.
+     * @see MonteCarloMethod::sampleQuasiBlock.
      */
-    void setSeed(const std::seed_seq& seed);
+    void sampleQuasiBlock(const ScrambledSobol& sequence, uint64_t first, uint64_t n,
+                          Accumulator& acc) const;
 
-private:
     /**
-     * Effectue un certain nombre donne de generations afin de mettre a jour les statistiques (somme, somme des
-     * carres, moyenne, etc) afin de creer un IC pour l'aire estimee.
-     *
-     * @param step Le nombre de generation qui seront effectuees.
+     * @see MonteCarloMethod::supportsAntithetic.
      */
-    void sample(uint64_t step);
+    bool supportsAntithetic() const;
 
+private:
     /**
-     * Empaquete toutes les valeurs associees a l'echantillon (aire estimee, IC, etc: voir MonteCarloMethod::Sampling).
+     * Calcule les valeurs associees a un lot de points de [0,1): g(X) avec X ~ U(a,b), ou en mode antithetique la
+     * moyenne de g(X) et de g(a + b - X).
      *
-     * @return L'echantillon cree.
+     * @param us Les points de [0,1) (au plus BATCH_SIZE).
+     * @param values Le tampon dans lequel ecrire les valeurs.
+     * @param m Le nombre de points.
      */
-    Sampling createSampling(double timeElapsed) const;
+    void evaluatePoints(const double* us, double* values, size_t m) const;
 };
 
-#endif // UNIFORMS_AMPLING_H
+#endif // UNIFORM_SAMPLING_H
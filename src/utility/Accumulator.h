@@ -0,0 +1,157 @@
+#ifndef ACCUMULATOR_H
+#define ACCUMULATOR_H
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Accumule un flux de valeurs sous une forme numeriquement stable: nombre de valeurs, moyenne et somme des carres des
+ * ecarts a la moyenne (plutot que la somme et la somme des carres, dont la difference perd toute precision sur de
+ * tres grands echantillons et peut donner une variance negative).
+ *
+ * Les valeurs sont ajoutees par lots: la moyenne et les ecarts du lot sont calcules en deux passes vectorisables,
+ * puis le lot est fusionne avec les valeurs precedentes (formule de Chan et al.). Deux accumulateurs peuvent etre
+ * fusionnes de la meme facon (ex: shards du mode parallele).
+ */
+class Accumulator {
+private:
+    static const size_t LANES = 4; // nombre de sommes partielles independantes lors du traitement d'un lot
+
+    uint64_t n = 0;  // nombre de valeurs
+    double mu = 0;   // moyenne des valeurs
+    double m2 = 0;   // somme des carres des ecarts a la moyenne
+
+public:
+    Accumulator() = default;
+
+    /**
+     * Cree un accumulateur a partir du resume d'un groupe de valeurs (ex: valeurs calculees a partir de moments, sans
+     * avoir ete generees une a une).
+     *
+     * @param n Le nombre de valeurs.
+     * @param mean La moyenne des valeurs.
+     * @param m2 La somme des carres des ecarts a la moyenne.
+     */
+    Accumulator(uint64_t n, double mean, double m2) : n(n), mu(mean), m2(m2) {}
+
+    /**
+     * Ajoute une valeur (mise a jour de Welford).
+     */
+    void add(double value) {
+        ++n;
+        double delta = value - mu;
+        mu += delta / n;
+        m2 += delta * (value - mu);
+    }
+
+    /**
+     * Ajoute un lot de valeurs.
+     *
+     * @param values Les valeurs.
+     * @param m Le nombre de valeurs.
+     */
+    void add(const double* values, size_t m) {
+        if (m == 0) {
+            return;
+        }
+
+        double batchMean = sum(values, m) / m;
+        combine(m, batchMean, squaredDeviations(values, m, batchMean));
+    }
+
+    /**
+     * Ajoute les valeurs d'un autre accumulateur.
+     */
+    void merge(const Accumulator& other) {
+        combine(other.n, other.mu, other.m2);
+    }
+
+    /**
+     * @return Le nombre de valeurs.
+     */
+    uint64_t count() const {
+        return n;
+    }
+
+    /**
+     * @return La moyenne des valeurs.
+     */
+    double mean() const {
+        return mu;
+    }
+
+    /**
+     * @return La somme des carres des ecarts a la moyenne (voir Accumulator(uint64_t, double, double)).
+     */
+    double sumSquaredDeviations() const {
+        return m2;
+    }
+
+    /**
+     * @return La variance (non corrigee) des valeurs: jamais negative.
+     */
+    double variance() const {
+        return n > 0 ? m2 / n : 0;
+    }
+
+private:
+    /**
+     * Somme des valeurs avec plusieurs sommes partielles: les additions successives ne dependent pas les unes des
+     * autres et peuvent etre vectorisees.
+     */
+    static double sum(const double* values, size_t m) {
+        double partial[LANES] = {0};
+
+        size_t i = 0;
+        for (; i + LANES <= m; i += LANES) {
+            for (size_t j = 0; j < LANES; ++j) {
+                partial[j] += values[i + j];
+            }
+        }
+
+        double total = (partial[0] + partial[1]) + (partial[2] + partial[3]);
+        for (; i < m; ++i) {
+            total += values[i];
+        }
+        return total;
+    }
+
+    /**
+     * Somme des carres des ecarts des valeurs a une moyenne donnee (meme principe que sum).
+     */
+    static double squaredDeviations(const double* values, size_t m, double center) {
+        double partial[LANES] = {0};
+
+        size_t i = 0;
+        for (; i + LANES <= m; i += LANES) {
+            for (size_t j = 0; j < LANES; ++j) {
+                double d = values[i + j] - center;
+                partial[j] += d * d;
+            }
+        }
+
+        double total = (partial[0] + partial[1]) + (partial[2] + partial[3]);
+        for (; i < m; ++i) {
+            double d = values[i] - center;
+            total += d * d;
+        }
+        return total;
+    }
+
+    /**
+     * Fusionne un groupe de valeurs resume par son nombre, sa moyenne et la somme des carres de ses ecarts.
+     */
+    void combine(uint64_t nB, double muB, double m2B) {
+        if (nB == 0) {
+            return;
+        }
+
+        uint64_t total = n + nB;
+        double delta = muB - mu;
+        mu += delta * ((double)nB / total);
+        m2 += m2B + delta * delta * ((double)n * nB / total);
+        n = total;
+    }
+};
+
+#endif // ACCUMULATOR_H
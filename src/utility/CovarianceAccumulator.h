@@ -0,0 +1,145 @@
+#ifndef COVARIANCE_ACCUMULATOR_H
+#define COVARIANCE_ACCUMULATOR_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Equivalent d'Accumulator pour un flux de vecteurs de dimension d: nombre de vecteurs, moyenne de chaque
+ * composante et sommes des produits des ecarts a la moyenne (co-moments, d * d valeurs). La memoire utilisee ne
+ * depend pas du nombre de vecteurs.
+ *
+ * Les vecteurs sont ajoutes par lots (une colonne par composante): la moyenne et les co-moments du lot sont calcules
+ * en deux passes vectorisables, puis le lot est fusionne avec les vecteurs precedents (formule de Chan et al.).
+ */
+class CovarianceAccumulator {
+private:
+    size_t dim = 0;           // dimension des vecteurs
+    uint64_t n = 0;           // nombre de vecteurs
+    std::vector<double> mu;   // moyenne de chaque composante
+    std::vector<double> m2;   // co-moments, ligne par ligne (matrice symetrique)
+
+    // moyennes et co-moments du lot en cours d'ajout (reutilises d'un lot a l'autre: pas d'allocation par lot)
+    std::vector<double> batchMean, batchM2;
+
+public:
+    CovarianceAccumulator() = default;
+
+    /**
+     * @param dim La dimension des vecteurs.
+     */
+    explicit CovarianceAccumulator(size_t dim)
+            : dim(dim), mu(dim, 0), m2(dim * dim, 0), batchMean(dim), batchM2(dim * dim) {}
+
+    /**
+     * Cree un accumulateur a partir du resume d'un groupe de vecteurs (ex: etat recu d'un autre processus).
+     *
+     * @param n Le nombre de vecteurs.
+     * @param mu La moyenne de chaque composante (dim valeurs).
+     * @param m2 Les co-moments, ligne par ligne (dim * dim valeurs).
+     */
+    CovarianceAccumulator(uint64_t n, std::vector<double> mu, std::vector<double> m2)
+            : dim(mu.size()), n(n), mu(std::move(mu)), m2(std::move(m2)), batchMean(dim), batchM2(dim * dim) {}
+
+    /**
+     * Ajoute un lot de vecteurs.
+     *
+     * @param columns Les colonnes du lot: columns[i] pointe sur les m valeurs de la composante i.
+     * @param m Le nombre de vecteurs.
+     */
+    void add(const double* const* columns, size_t m) {
+        if (m == 0) {
+            return;
+        }
+
+        for (size_t i = 0; i < dim; ++i) {
+            double sum = 0;
+            for (size_t t = 0; t < m; ++t) {
+                sum += columns[i][t];
+            }
+            batchMean[i] = sum / m;
+        }
+
+        for (size_t i = 0; i < dim; ++i) {
+            for (size_t j = 0; j <= i; ++j) {
+                double sum = 0;
+                for (size_t t = 0; t < m; ++t) {
+                    sum += (columns[i][t] - batchMean[i]) * (columns[j][t] - batchMean[j]);
+                }
+                batchM2[i * dim + j] = batchM2[j * dim + i] = sum;
+            }
+        }
+
+        combine(m, batchMean, batchM2);
+    }
+
+    /**
+     * Ajoute les vecteurs d'un autre accumulateur (de meme dimension).
+     */
+    void merge(const CovarianceAccumulator& other) {
+        combine(other.n, other.mu, other.m2);
+    }
+
+    /**
+     * @return La dimension des vecteurs.
+     */
+    size_t dimension() const {
+        return dim;
+    }
+
+    /**
+     * @return Le nombre de vecteurs.
+     */
+    uint64_t count() const {
+        return n;
+    }
+
+    /**
+     * @return La moyenne de la composante i.
+     */
+    double mean(size_t i) const {
+        return mu[i];
+    }
+
+    /**
+     * @return La somme des produits des ecarts a la moyenne des composantes i et j.
+     */
+    double comoment(size_t i, size_t j) const {
+        return m2[i * dim + j];
+    }
+
+    /**
+     * @return La covariance (non corrigee) des composantes i et j.
+     */
+    double covariance(size_t i, size_t j) const {
+        return n > 0 ? m2[i * dim + j] / n : 0;
+    }
+
+private:
+    /**
+     * Fusionne un groupe de vecteurs resume par son nombre, ses moyennes et ses co-moments.
+     */
+    void combine(uint64_t nB, const std::vector<double>& muB, const std::vector<double>& m2B) {
+        if (nB == 0) {
+            return;
+        }
+
+        uint64_t total = n + nB;
+        double factor = (double)n * nB / total;
+
+        for (size_t i = 0; i < dim; ++i) {
+            double deltaI = muB[i] - mu[i];
+            for (size_t j = 0; j < dim; ++j) {
+                m2[i * dim + j] += m2B[i * dim + j] + deltaI * (muB[j] - mu[j]) * factor;
+            }
+        }
+        for (size_t i = 0; i < dim; ++i) {
+            mu[i] += (muB[i] - mu[i]) * ((double)nB / total);
+        }
+        n = total;
+    }
+};
+
+#endif // COVARIANCE_ACCUMULATOR_H
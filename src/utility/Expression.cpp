@@ -0,0 +1,503 @@
+#include <stdexcept>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstdlib>
+#include <cctype>
+#include <cstdint>
+
+#include "Expression.h"
+#include "FastMath.h"
+
+// nombre de points traites a la fois par l'interpreteur
+static const size_t CHUNK_SIZE = 256;
+
+// taille de pile au-dela de laquelle la pile est allouee sur le tas
+static const size_t LOCAL_DEPTH = 16;
+
+// plus grand exposant entier traite par multiplications successives (POW_I)
+static const double MAX_INTEGER_POWER = 64;
+
+/**
+ * Applique une instruction a des valeurs (calcul des constantes et evaluation des fonctions hors du domaine de
+ * FastMath).
+ */
+static double apply(Expression::Op op, double x, double y) {
+    typedef Expression::Op Op;
+
+    switch (op) {
+        case Op::ADD: return x + y;
+        case Op::SUB: return x - y;
+        case Op::MUL: return x * y;
+        case Op::DIV: return x / y;
+        case Op::POW: return std::pow(x, y);
+        case Op::MIN: return std::min(x, y);
+        case Op::MAX: return std::max(x, y);
+        case Op::NEG: return -x;
+        case Op::EXP: return std::exp(x);
+        case Op::LOG: return std::log(x);
+        case Op::SQRT: return std::sqrt(x);
+        case Op::COS: return std::cos(x);
+        case Op::SIN: return std::sin(x);
+        case Op::TAN: return std::tan(x);
+        case Op::ABS: return std::fabs(x);
+        default: throw std::logic_error("Instruction non calculable directement.");
+    }
+}
+
+/**
+ * Analyse l'expression (descente recursive) en un arbre, calcule les sous-expressions constantes puis produit le code.
+ */
+class Expression::Compiler {
+private:
+    struct Node {
+        Op op;
+        double value = 0;                     // valeur d'une constante
+        std::unique_ptr<Node> left, right;    // operandes (left seul pour une fonction d'un argument)
+    };
+
+    typedef std::unique_ptr<Node> NodePtr;
+
+    const std::string& source;
+    size_t pos = 0;
+
+    std::vector<Instruction>& code;
+    size_t height = 0;    // taille de la pile apres les instructions deja produites
+    size_t& depth;
+
+public:
+    Compiler(const std::string& source, std::vector<Instruction>& code, size_t& depth)
+            : source(source), code(code), depth(depth) {}
+
+    void compile() {
+        NodePtr root = parseSum();
+        skipSpaces();
+        if (pos < source.size()) {
+            fail("caractere inattendu '" + std::string(1, source[pos]) + "'");
+        }
+        emit(*root);
+    }
+
+private:
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::invalid_argument("Expression invalide (position " + std::to_string(pos + 1) + "): " + message + ".");
+    }
+
+    void skipSpaces() {
+        while (pos < source.size() && std::isspace((unsigned char)source[pos])) {
+            ++pos;
+        }
+    }
+
+    /**
+     * Consomme un caractere s'il est le prochain caractere (apres les espaces).
+     */
+    bool accept(char c) {
+        skipSpaces();
+        if (pos < source.size() && source[pos] == c) {
+            ++pos;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char c) {
+        if (!accept(c)) {
+            fail(std::string("'") + c + "' attendu");
+        }
+    }
+
+    static NodePtr constant(double value) {
+        NodePtr node(new Node());
+        node->op = Op::CONST;
+        node->value = value;
+        return node;
+    }
+
+    /**
+     * Cree un noeud, calcule directement si ses operandes sont constantes.
+     */
+    static NodePtr make(Op op, NodePtr left, NodePtr right = NodePtr()) {
+        if (left->op == Op::CONST && (!right || right->op == Op::CONST)) {
+            return constant(apply(op, left->value, right ? right->value : 0));
+        }
+
+        NodePtr node(new Node());
+        node->op = op;
+        node->left = std::move(left);
+        node->right = std::move(right);
+        return node;
+    }
+
+    // somme := produit (('+' | '-') produit)*
+    NodePtr parseSum() {
+        NodePtr node = parseProduct();
+        for (;;) {
+            if (accept('+')) {
+                node = make(Op::ADD, std::move(node), parseProduct());
+            } else if (accept('-')) {
+                node = make(Op::SUB, std::move(node), parseProduct());
+            } else {
+                return node;
+            }
+        }
+    }
+
+    // produit := unaire (('*' | '/') unaire)*
+    NodePtr parseProduct() {
+        NodePtr node = parseUnary();
+        for (;;) {
+            if (accept('*')) {
+                node = make(Op::MUL, std::move(node), parseUnary());
+            } else if (accept('/')) {
+                node = make(Op::DIV, std::move(node), parseUnary());
+            } else {
+                return node;
+            }
+        }
+    }
+
+    // unaire := ('-' | '+') unaire | puissance
+    NodePtr parseUnary() {
+        if (accept('-')) {
+            return make(Op::NEG, parseUnary());
+        }
+        if (accept('+')) {
+            return parseUnary();
+        }
+        return parsePower();
+    }
+
+    // puissance := primaire ('^' unaire)?
+    NodePtr parsePower() {
+        NodePtr node = parsePrimary();
+        if (accept('^')) {
+            node = make(Op::POW, std::move(node), parseUnary());
+        }
+        return node;
+    }
+
+    // primaire := nombre | x | pi | e | fonction '(' somme (',' somme)? ')' | '(' somme ')'
+    NodePtr parsePrimary() {
+        skipSpaces();
+        if (pos == source.size()) {
+            fail("fin inattendue de l'expression");
+        }
+
+        if (accept('(')) {
+            NodePtr node = parseSum();
+            expect(')');
+            return node;
+        }
+
+        char c = source[pos];
+        if (std::isdigit((unsigned char)c) || c == '.') {
+            const char* begin = source.c_str() + pos;
+            char* end;
+            double value = std::strtod(begin, &end);
+            if (end == begin) {
+                fail("nombre invalide");
+            }
+            pos += end - begin;
+            return constant(value);
+        }
+
+        if (!std::isalpha((unsigned char)c)) {
+            fail("caractere inattendu '" + std::string(1, c) + "'");
+        }
+
+        size_t start = pos;
+        while (pos < source.size() && std::isalnum((unsigned char)source[pos])) {
+            ++pos;
+        }
+        std::string name = source.substr(start, pos - start);
+
+        if (name == "x") {
+            NodePtr node(new Node());
+            node->op = Op::X;
+            return node;
+        }
+        if (name == "pi") {
+            return constant(std::acos(-1.0));
+        }
+        if (name == "e") {
+            return constant(std::exp(1.0));
+        }
+
+        static const struct {
+            const char* name;
+            Op op;
+            int arity;
+        } FUNCTIONS[] = {
+                {"exp", Op::EXP, 1}, {"log", Op::LOG, 1}, {"sqrt", Op::SQRT, 1}, {"cos", Op::COS, 1},
+                {"sin", Op::SIN, 1}, {"tan", Op::TAN, 1}, {"abs", Op::ABS, 1},
+                {"pow", Op::POW, 2}, {"min", Op::MIN, 2}, {"max", Op::MAX, 2}};
+
+        for (const auto& function : FUNCTIONS) {
+            if (name == function.name) {
+                expect('(');
+                NodePtr left = parseSum(), right;
+                if (function.arity == 2) {
+                    expect(',');
+                    right = parseSum();
+                }
+                expect(')');
+                return make(function.op, std::move(left), std::move(right));
+            }
+        }
+
+        pos = start;
+        fail("nom inconnu '" + name + "'");
+    }
+
+    void push(Op op, double value = 0) {
+        code.push_back({op, value});
+    }
+
+    /**
+     * Produit le code d'un noeud: a la fin, sa valeur est au sommet de la pile.
+     */
+    void emit(const Node& node) {
+        switch (node.op) {
+            case Op::X:
+            case Op::CONST:
+                push(node.op, node.value);
+                depth = std::max(depth, ++height);
+                return;
+
+            case Op::ADD: case Op::SUB: case Op::MUL: case Op::DIV: case Op::POW: case Op::MIN: case Op::MAX:
+                emitBinary(node);
+                return;
+
+            default:
+                emit(*node.left);
+                push(node.op);
+                return;
+        }
+    }
+
+    void emitBinary(const Node& node) {
+        const Node& left = *node.left;
+        const Node& right = *node.right;
+
+        // operande droit constant
+        if (right.op == Op::CONST) {
+            double c = right.value;
+            Op op;
+            switch (node.op) {
+                case Op::ADD: op = Op::ADD_C; break;
+                case Op::SUB: op = Op::SUB_C; break;
+                case Op::MUL: op = Op::MUL_C; break;
+                case Op::DIV: op = Op::DIV_C; break;
+                case Op::POW:
+                    op = c == std::floor(c) && std::fabs(c) <= MAX_INTEGER_POWER ? Op::POW_I : Op::POW;
+                    break;
+                default: op = node.op; break;
+            }
+            if (op != node.op) {
+                emit(left);
+                push(op, c);
+                return;
+            }
+        }
+
+        // operande gauche constant
+        if (left.op == Op::CONST) {
+            double c = left.value;
+            Op op;
+            switch (node.op) {
+                case Op::ADD: op = Op::ADD_C; break;
+                case Op::SUB: op = Op::RSUB_C; break;
+                case Op::MUL: op = Op::MUL_C; break;
+                case Op::DIV: op = Op::RDIV_C; break;
+                default: op = node.op; break;
+            }
+            if (op != node.op) {
+                emit(right);
+                push(op, c);
+                return;
+            }
+        }
+
+        emit(left);
+        emit(right);
+        push(node.op);
+        --height;
+    }
+};
+
+
+Expression::Expression(const std::string& source) : source(source) {
+    Compiler(this->source, code, depth).compile();
+}
+
+double Expression::operator()(double x) const {
+    double y;
+    if (depth <= LOCAL_DEPTH) {
+        double stack[LOCAL_DEPTH];
+        execute(&x, &y, 1, stack);
+    } else {
+        std::vector<double> stack(depth);
+        execute(&x, &y, 1, stack.data());
+    }
+    return y;
+}
+
+void Expression::operator()(const double* x, double* y, size_t n) const {
+    double local[LOCAL_DEPTH * CHUNK_SIZE];
+    std::vector<double> heap;
+    double* stack = local;
+    if (depth > LOCAL_DEPTH) {
+        heap.resize(depth * CHUNK_SIZE);
+        stack = heap.data();
+    }
+
+    for (size_t done = 0; done < n; done += CHUNK_SIZE) {
+        size_t m = std::min(CHUNK_SIZE, n - done);
+        execute(x + done, y + done, m, stack);
+    }
+}
+
+/**
+ * Indique si toutes les valeurs sont dans [lo, hi] (ou nulles si zero vaut true), sans branchement.
+ */
+static bool within(const double* v, size_t m, double lo, double hi, bool zero = false) {
+    bool inside = true;
+    for (size_t i = 0; i < m; ++i) {
+        inside &= ((v[i] >= lo) & (v[i] <= hi)) | (zero & (v[i] == 0));
+    }
+    return inside;
+}
+
+void Expression::execute(const double* x, double* y, size_t m, double* stack) const {
+    size_t top = 0; // nombre de tableaux dans la pile
+
+    for (const Instruction& instruction : code) {
+        double c = instruction.value;
+        double* next = stack + top * m;                    // emplacement d'un nouveau tableau
+        double* a = top > 0 ? next - m : next;             // sommet de la pile
+        double* b = top > 1 ? a - m : a;                   // tableau sous le sommet (operande gauche)
+
+        switch (instruction.op) {
+            case Op::X:
+                std::copy(x, x + m, next);
+                ++top;
+                break;
+            case Op::CONST:
+                std::fill(next, next + m, c);
+                ++top;
+                break;
+
+            case Op::ADD:
+                for (size_t i = 0; i < m; ++i) b[i] += a[i];
+                --top;
+                break;
+            case Op::SUB:
+                for (size_t i = 0; i < m; ++i) b[i] -= a[i];
+                --top;
+                break;
+            case Op::MUL:
+                for (size_t i = 0; i < m; ++i) b[i] *= a[i];
+                --top;
+                break;
+            case Op::DIV:
+                for (size_t i = 0; i < m; ++i) b[i] /= a[i];
+                --top;
+                break;
+            case Op::POW:
+                for (size_t i = 0; i < m; ++i) b[i] = std::pow(b[i], a[i]);
+                --top;
+                break;
+            case Op::MIN:
+                for (size_t i = 0; i < m; ++i) b[i] = std::min(b[i], a[i]);
+                --top;
+                break;
+            case Op::MAX:
+                for (size_t i = 0; i < m; ++i) b[i] = std::max(b[i], a[i]);
+                --top;
+                break;
+
+            case Op::ADD_C:
+                for (size_t i = 0; i < m; ++i) a[i] += c;
+                break;
+            case Op::SUB_C:
+                for (size_t i = 0; i < m; ++i) a[i] -= c;
+                break;
+            case Op::RSUB_C:
+                for (size_t i = 0; i < m; ++i) a[i] = c - a[i];
+                break;
+            case Op::MUL_C:
+                for (size_t i = 0; i < m; ++i) a[i] *= c;
+                break;
+            case Op::DIV_C:
+                for (size_t i = 0; i < m; ++i) a[i] /= c;
+                break;
+            case Op::RDIV_C:
+                for (size_t i = 0; i < m; ++i) a[i] = c / a[i];
+                break;
+            case Op::POW_I: {
+                // exponentiation rapide, appliquee a tout le lot bit par bit de l'exposant
+                double result[CHUNK_SIZE];
+                std::fill(result, result + m, 1.0);
+                for (uint64_t e = (uint64_t)std::fabs(c); e > 0; e >>= 1) {
+                    if (e & 1) {
+                        for (size_t i = 0; i < m; ++i) result[i] *= a[i];
+                    }
+                    for (size_t i = 0; i < m; ++i) a[i] *= a[i];
+                }
+                if (c < 0) {
+                    for (size_t i = 0; i < m; ++i) a[i] = 1 / result[i];
+                } else {
+                    std::copy(result, result + m, a);
+                }
+                break;
+            }
+
+            case Op::NEG:
+                for (size_t i = 0; i < m; ++i) a[i] = -a[i];
+                break;
+            case Op::ABS:
+                for (size_t i = 0; i < m; ++i) a[i] = std::fabs(a[i]);
+                break;
+
+            // FastMath si toutes les valeurs du lot sont dans son domaine, <cmath> sinon
+            case Op::EXP:
+                if (within(a, m, -708, 708)) {
+                    FastMath::exp(a, a, m);
+                } else {
+                    for (size_t i = 0; i < m; ++i) a[i] = std::exp(a[i]);
+                }
+                break;
+            case Op::LOG:
+                if (within(a, m, DBL_MIN, DBL_MAX)) {
+                    FastMath::log(a, a, m);
+                } else {
+                    for (size_t i = 0; i < m; ++i) a[i] = std::log(a[i]);
+                }
+                break;
+            case Op::SQRT:
+                if (within(a, m, DBL_MIN, DBL_MAX, true)) {
+                    FastMath::sqrt(a, a, m);
+                } else {
+                    for (size_t i = 0; i < m; ++i) a[i] = std::sqrt(a[i]);
+                }
+                break;
+            case Op::COS:
+                if (within(a, m, -1048576, 1048576)) {
+                    FastMath::cos(a, a, m);
+                } else {
+                    for (size_t i = 0; i < m; ++i) a[i] = std::cos(a[i]);
+                }
+                break;
+            case Op::SIN:
+                for (size_t i = 0; i < m; ++i) a[i] = std::sin(a[i]);
+                break;
+            case Op::TAN:
+                for (size_t i = 0; i < m; ++i) a[i] = std::tan(a[i]);
+                break;
+        }
+    }
+
+    std::copy(stack, stack + m, y);
+}
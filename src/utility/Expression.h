@@ -0,0 +1,101 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/**
+ * Fonction d'une variable x definie par une expression lue a l'execution, par exemple
+ * "(25 + x*(x-6)*(x-8)*(x-14)/25) * exp(sqrt(1 + cos(x^2/10)))".
+ *
+ * Syntaxe: nombres (ex: 2, 0.5, 1e-3), variable x, constantes pi et e, operateurs + - * / et ^ (puissance, associatif
+ * a droite et prioritaire sur le - unaire: -x^2 = -(x^2)), parentheses et fonctions exp, log, sqrt, cos, sin, tan,
+ * abs, pow(a, b), min(a, b) et max(a, b).
+ *
+ * L'expression est compilee en un code a pile (les sous-expressions constantes sont calculees a la compilation et les
+ * operations avec une constante ont leurs propres instructions). Le code est interprete sur des lots de points:
+ * chaque instruction est appliquee a tout le lot par une boucle vectorisable (exp, log, sqrt et cos utilisent
+ * FastMath lorsque toutes les valeurs du lot sont dans son domaine), ce qui amortit le cout de l'interpretation.
+ *
+ * Une Expression peut etre utilisee comme MonteCarloMethod::Func (appel sur un point) et comme fonction evaluee par
+ * lots (voir BatchIntegrand): les methodes l'evaluent alors directement sur les lots de points generes.
+ */
+class Expression {
+public:
+    /**
+     * Instructions du code a pile. Les instructions *_C ont une constante comme operande droit (RSUB_C et RDIV_C
+     * comme operande gauche); POW_I eleve a une puissance entiere constante.
+     */
+    enum class Op {
+        X, CONST,
+        ADD, SUB, MUL, DIV, POW, MIN, MAX,
+        ADD_C, SUB_C, RSUB_C, MUL_C, DIV_C, RDIV_C, POW_I,
+        NEG, EXP, LOG, SQRT, COS, SIN, TAN, ABS
+    };
+
+    struct Instruction {
+        Op op;
+        double value; // constante de l'instruction (CONST, *_C et POW_I)
+    };
+
+private:
+    class Compiler;
+
+    std::string source;               // expression source
+    std::vector<Instruction> code;    // code a pile
+    size_t depth = 0;                 // taille maximale de la pile
+
+public:
+    /**
+     * Compile une expression.
+     *
+     * @param source L'expression.
+     * @throw std::invalid_argument Si l'expression n'est pas valide (le message indique la position de l'erreur).
+     */
+    explicit Expression(const std::string& source);
+
+    /**
+     * Evalue l'expression en un point.
+     *
+     * @param x La valeur de la variable.
+     * @return La valeur de l'expression.
+     */
+    double operator()(double x) const;
+
+    /**
+     * Evalue l'expression sur un lot de points. Peut etre appelee simultanement depuis plusieurs threads.
+     *
+     * @param x Les valeurs de la variable.
+     * @param y Le tampon dans lequel ecrire les valeurs de l'expression.
+     * @param n Le nombre de points.
+     */
+    void operator()(const double* x, double* y, size_t n) const;
+
+    /**
+     * @return L'expression source.
+     */
+    const std::string& getSource() const {
+        return source;
+    }
+
+    /**
+     * @return Le code compile (ex: pour verifier le resultat des optimisations).
+     */
+    const std::vector<Instruction>& getCode() const {
+        return code;
+    }
+
+private:
+    /**
+     * Execute le code sur un groupe de m points.
+     *
+     * @param x Les valeurs de la variable.
+     * @param y Le tampon dans lequel ecrire les valeurs de l'expression.
+     * @param m Le nombre de points.
+     * @param stack La pile: depth tableaux de m valeurs.
+     */
+    void execute(const double* x, double* y, size_t m, double* stack) const;
+};
+
+#endif // EXPRESSION_H
@@ -0,0 +1,212 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Approximations de exp, log, sqrt et cos pouvant etre vectorisees par le compilateur.
+ *
+ * Les fonctions de <cmath> ne sont pas vectorisees dans une boucle (appels a la bibliotheque, errno): une fonction
+ * evaluee par lots (voir Integrand) qui les appelle traite ses points un par un. Les fonctions de FastMath sont
+ * mises en ligne et sans branchement (reduction de l'argument par manipulation de bits, polynome, selection par
+ * masque): une boucle qui les appelle est vectorisee (2 doubles par instruction en SSE2, 4 en AVX2).
+ *
+ * Les bornes d'erreur (erreur relative maximale par rapport a <cmath>, mesuree sur 10^8 points du domaine) sont
+ * donnees pour chaque fonction. Les arguments hors du domaine indique (NaN, infinis, sous-normaux, ...) ne sont pas
+ * traites et donnent un resultat non specifie.
+ */
+class FastMath {
+private:
+    static double fromBits(uint64_t bits) {
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        return d;
+    }
+
+    static uint64_t toBits(double d) {
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        return bits;
+    }
+
+    /**
+     * Choix sans branchement entre deux doubles (le compilateur ne vectorise pas toujours l'operateur ?:).
+     */
+    static double select(bool condition, double ifTrue, double ifFalse) {
+        uint64_t mask = 0 - (uint64_t)condition;
+        return fromBits((toBits(ifTrue) & mask) | (toBits(ifFalse) & ~mask));
+    }
+
+    /**
+     * Arrondit a l'entier le plus proche (|x| < 2^51): le resultat est exact et les bits de poids faible de
+     * x + ROUNDER contiennent l'entier (complement a deux).
+     */
+    static constexpr double ROUNDER = 6755399441055744.0; // 1.5 * 2^52
+
+public:
+    /**
+     * Exponentielle: reduction x = k ln(2) + r (|r| <= ln(2)/2), polynome de degre 12 en r, puis multiplication par 2^k
+     * construit bit a bit.
+     *
+     * Domaine: [-708, 708] (les arguments hors de cet intervalle y sont ramenes). Erreur relative: 4.7e-16 (2 ulp).
+     */
+    static double exp(double x) {
+        const double LOG2E = 1.4426950408889634;
+        const double LN2_HI = 6.93147180369123816490e-01, LN2_LO = 1.90821492927058770002e-10;
+
+        x = std::fabs(x) > 708 ? std::copysign(708.0, x) : x;
+
+        double t = x * LOG2E + ROUNDER;
+        double k = t - ROUNDER;
+        double r = (x - k * LN2_HI) - k * LN2_LO;
+
+        // serie de Taylor tronquee (Horner)
+        double p = 1.0 / 479001600;
+        p = p * r + 1.0 / 39916800;
+        p = p * r + 1.0 / 3628800;
+        p = p * r + 1.0 / 362880;
+        p = p * r + 1.0 / 40320;
+        p = p * r + 1.0 / 5040;
+        p = p * r + 1.0 / 720;
+        p = p * r + 1.0 / 120;
+        p = p * r + 1.0 / 24;
+        p = p * r + 1.0 / 6;
+        p = p * r + 0.5;
+        p = p * r + 1.0;
+        p = p * r + 1.0;
+
+        // 2^k: k est dans les bits de poids faible de t
+        double scale = fromBits((toBits(t) + 1023) << 52);
+        return p * scale;
+    }
+
+    /**
+     * Logarithme naturel: x = 2^e m avec m dans [sqrt(2)/2, sqrt(2)), puis log(m) = 2 atanh(f) avec
+     * f = (m - 1) / (m + 1) (|f| <= 0.172), serie impaire en f jusqu'a f^21.
+     *
+     * Domaine: doubles normaux strictement positifs. Erreur relative: 4.4e-16 (2 ulp), erreur absolue 2.2e-16
+     * pres de 1.
+     */
+    static double log(double x) {
+        const double LN2 = 0.6931471805599453;
+        const uint64_t SQRT2_2 = 0x3FE6A09E667F3BCDULL; // sqrt(2)/2
+
+        // decalage tel que l'exposant de x change en sqrt(2): m dans [sqrt(2)/2, sqrt(2)) et x = 2^e m
+        uint64_t bits = toBits(x) + (0x3FF0000000000000ULL - SQRT2_2);
+        double e = fromBits(0x4330000000000000ULL | (bits >> 52)) - (4503599627370496.0 + 1023);
+        double m = fromBits((bits & 0x000FFFFFFFFFFFFFULL) + SQRT2_2);
+
+        double f = (m - 1) / (m + 1);
+        double f2 = f * f;
+
+        double p = 1.0 / 21;
+        p = p * f2 + 1.0 / 19;
+        p = p * f2 + 1.0 / 17;
+        p = p * f2 + 1.0 / 15;
+        p = p * f2 + 1.0 / 13;
+        p = p * f2 + 1.0 / 11;
+        p = p * f2 + 1.0 / 9;
+        p = p * f2 + 1.0 / 7;
+        p = p * f2 + 1.0 / 5;
+        p = p * f2 + 1.0 / 3;
+
+        return e * LN2 + 2 * f + 2 * f * f2 * p;
+    }
+
+    /**
+     * Racine carree: approximation initiale de 1/sqrt(x) par manipulation de bits, trois iterations de Newton, puis
+     * une correction de sqrt(x) = x / sqrt(x).
+     *
+     * Domaine: 0 et doubles normaux positifs finis. Erreur relative: 2.2e-16 (1 ulp).
+     */
+    static double sqrt(double x) {
+        double r = fromBits(0x5FE6EB50C7B537A9ULL - (toBits(x) >> 1));
+        double half = 0.5 * x;
+
+        r = r * (1.5 - half * r * r);
+        r = r * (1.5 - half * r * r);
+        r = r * (1.5 - half * r * r);
+
+        double y = x * r;
+        return y + 0.5 * r * (x - y * y);
+    }
+
+    /**
+     * Cosinus: reduction x = k pi/2 + r (|r| <= pi/4, pi/2 decoupe en quatre termes), polynomes de cos(r) et sin(r)
+     * (series de Taylor jusqu'a r^16 et r^17), puis choix du polynome et du signe selon le quadrant k mod 4.
+     *
+     * Domaine: |x| <= 2^20 (la reduction perd de la precision au-dela). Erreur absolue: 2.2e-16; erreur relative
+     * 3.2e-16 (2 ulp) si |cos(x)| > 0.1.
+     */
+    static double cos(double x) {
+        const double TWO_OVER_PI = 0.63661977236758134308;
+        const double PIO2_1 = 1.57079632673412561417e+00, PIO2_2 = 6.07710050630396597660e-11;
+        const double PIO2_3 = 2.02226624871116645580e-21, PIO2_3T = 8.47842766036889956997e-32;
+
+        double t = x * TWO_OVER_PI + ROUNDER;
+        double k = t - ROUNDER;
+        double r = x - k * PIO2_1;
+        r -= k * PIO2_2;
+        r -= k * PIO2_3;
+        r -= k * PIO2_3T;
+
+        double r2 = r * r;
+
+        double c = 1.0 / 20922789888000;
+        c = c * r2 - 1.0 / 87178291200;
+        c = c * r2 + 1.0 / 479001600;
+        c = c * r2 - 1.0 / 3628800;
+        c = c * r2 + 1.0 / 40320;
+        c = c * r2 - 1.0 / 720;
+        c = c * r2 + 1.0 / 24;
+        c = c * r2 - 0.5;
+        c = c * r2 + 1.0;
+
+        double s = 1.0 / 355687428096000;
+        s = s * r2 - 1.0 / 1307674368000;
+        s = s * r2 + 1.0 / 6227020800;
+        s = s * r2 - 1.0 / 39916800;
+        s = s * r2 + 1.0 / 362880;
+        s = s * r2 - 1.0 / 5040;
+        s = s * r2 + 1.0 / 120;
+        s = s * r2 - 1.0 / 6;
+        s = s * r2 * r + r;
+
+        // cos(r + k pi/2) = cos(r), -sin(r), -cos(r), sin(r) selon k mod 4
+        uint64_t q = toBits(t);
+        uint64_t sign = ((q + 1) & 2) << 62;
+        return fromBits(toBits(select(q & 1, s, c)) ^ sign);
+    }
+
+    /**
+     * Versions par lots: y[i] = f(x[i]) pour i < n (x et y peuvent etre le meme tampon).
+     */
+    static void exp(const double* x, double* y, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            y[i] = exp(x[i]);
+        }
+    }
+
+    static void log(const double* x, double* y, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            y[i] = log(x[i]);
+        }
+    }
+
+    static void sqrt(const double* x, double* y, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            y[i] = sqrt(x[i]);
+        }
+    }
+
+    static void cos(const double* x, double* y, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            y[i] = cos(x[i]);
+        }
+    }
+};
+
+#endif // FAST_MATH_H
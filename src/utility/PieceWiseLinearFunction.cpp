@@ -1,53 +1,25 @@
 #include "PiecewiseLinearFunction.h"
 
-PiecewiseLinearFunction::PiecewiseLinearFunction(const std::vector<double>& xs, const std::vector<double>& ys) {
+PiecewiseLinearFunction::PiecewiseLinearFunction(const std::vector<double>& xs, const std::vector<double>& ys)
+        : xs(xs), ys(ys) {
 
-    pieces.reserve(xs.size());
-    for (uint64_t i = 0; i < xs.size(); ++i) {
-
-        // creation d'un morceau de la fonction
-        if (i < xs.size() - 1) {
-
-            // ajout preliminaire des abscisses et ordonnees
-            Piece s {xs[i], xs[i+1], ys[i], ys[i+1]};
+    if (xs.size() < 2) {
+        return;
+    }
 
-            // aire sous le morceau de fonction
-            s.A_k = (ys[i+1] + ys[i]) * (xs[i+1] - xs[i]) / 2;
+    slopes.reserve(xs.size() - 1);
+    for (uint64_t i = 0; i < xs.size() - 1; ++i) {
 
-            // morceau de fonction
-            s.f_k = [&xs, &ys, i](double x) {
-                double m = (ys[i + 1] - ys[i]) / (xs[i+1] - xs[i]);
-                return m * (x - xs[i]) + ys[i];
-            };
+        // pente du morceau de fonction
+        slopes.push_back((ys[i + 1] - ys[i]) / (xs[i+1] - xs[i]));
 
-            // ajout du morceau
-            pieces.push_back(s);
-            A += s.A_k;
-        }
+        // aire sous le morceau de fonction
+        A += area(i);
     }
 }
 
-uint64_t PiecewiseLinearFunction::findPiece(double x) const {
-
-    uint64_t first = 0, last = pieces.size() - 1; // indices des tranches à prendre en compte
-
-    while (true) {
-
-        // il ne reste qu'une tranche -> x est dedans
-        if (first == last) {
-            return first;
-        }
-
-        // on regarde si x est dans la première ou deuxième moitié de l'intervalle de recherche
-        uint64_t mid = (last-first)/2 + first;
-        if (x < pieces[mid].x1) {   // première moitié
-            last = mid;
-        } else {                    // deuxième moitié
-            first = mid+1;
-        }
+void PiecewiseLinearFunction::evaluate(const double* x, double* y, size_t n) const {
+    for (size_t i = 0; i < n; ++i) {
+        y[i] = (*this)(x[i]);
     }
 }
-
-double PiecewiseLinearFunction::operator()(double x) const {
-    return pieces[findPiece(x)].f_k(x);
-}
\ No newline at end of file
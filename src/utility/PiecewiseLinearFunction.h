@@ -2,36 +2,90 @@
 #define PIECEWISE_LINEAR_FUNCTION_H
 
 #include <vector>
-#include <functional>
 #include <cstdint>
+#include <cstddef>
 
 /**
  * Regroupe les informations du "morceau" d'une fonction affine par morceaux.
+ *
+ * Simple vue construite a la demande (voir PiecewiseLinearFunction::piece): les donnees sont stockees sous forme de
+ * tableaux contigus dans PiecewiseLinearFunction.
  */
 struct Piece {
-
-    // fonction lineaire prenant un double et renvoyant un double
-    typedef std::function<double(double)> LinearFunc;
-
     double x0, x1;    // bornes de l'intervalle definissant le morceau
     double y0, y1;    // ordonnees correspodant aux bornes
     double A_k;       // aire sous la fonction f_k
-    LinearFunc f_k;   // fonction associée à ce morceau k.
 };
 
+/**
+ * Fonction affine par morceaux, stockee sous forme de tableaux contigus (24 octets par morceau): abscisses et
+ * ordonnees des points, pentes des morceaux. Le morceau k vaut f_k(x) = slopes[k] * (x - xs[k]) + ys[k].
+ */
 struct PiecewiseLinearFunction {
-    std::vector<Piece> pieces;   // "morceaux" de la fonction
+    std::vector<double> xs;      // abscisses des points (K+1 valeurs)
+    std::vector<double> ys;      // ordonnees des points (K+1 valeurs)
+    std::vector<double> slopes;  // pentes des morceaux (K valeurs)
     double A = 0;                // aire totale sous la fonction
 
     PiecewiseLinearFunction(const std::vector<double>& xs, const std::vector<double>& ys);
 
     /**
-     * Recherche dichotomique afin de trouver dans quel intervalle x se trouve.
+     * @return Le nombre de morceaux K.
+     */
+    size_t size() const {
+        return slopes.size();
+    }
+
+    /**
+     * @param k L'indice du morceau.
+     * @return Les informations du morceau k.
+     */
+    Piece piece(uint64_t k) const {
+        return {xs[k], xs[k+1], ys[k], ys[k+1], area(k)};
+    }
+
+    /**
+     * @param k L'indice du morceau.
+     * @return L'aire sous le morceau k.
+     */
+    double area(uint64_t k) const {
+        return (ys[k+1] + ys[k]) * (xs[k+1] - xs[k]) / 2;
+    }
+
+    /**
+     * Applique le morceau k (fonction affine associee) sur une valeur donnee.
+     *
+     * @param k L'indice du morceau.
+     * @param x L'abscisse dont on veut connaitre l'ordonnee.
+     * @return l'ordonnee.
+     */
+    double evalPiece(uint64_t k, double x) const {
+        return slopes[k] * (x - xs[k]) + ys[k];
+    }
+
+    /**
+     * Recherche dichotomique (sans branchement) afin de trouver dans quel intervalle x se trouve.
      *
      * @param x l'abscisse dont on veut connaître l'intervalle.
      * @return l'indice du morceau dans lequel x se trouve.
      */
-    uint64_t findPiece(double x) const;
+    uint64_t findPiece(double x) const {
+        // on cherche le nombre de bornes interieures xs[1..K-1] inferieures ou egales a x
+        if (size() <= 1) {
+            return 0;
+        }
+
+        const double* first = xs.data() + 1;
+        const double* base = first;
+        size_t n = size() - 1;
+
+        while (n > 1) {
+            size_t half = n / 2;
+            base = x < base[half] ? base : base + half;
+            n -= half;
+        }
+        return (base - first) + (x >= *base);
+    }
 
     /**
      * Simplifie l'ecriture de l'application de la fonction affine par morceau sur une valeur donnee.
@@ -40,7 +94,18 @@ struct PiecewiseLinearFunction {
      * @param x L'abscisse dont on veut connaitre l'ordonnee.
      * @return l'ordonnee.
      */
-    double operator()(double x) const;
+    double operator()(double x) const {
+        return evalPiece(findPiece(x), x);
+    }
+
+    /**
+     * Applique la fonction affine par morceaux sur un lot de valeurs.
+     *
+     * @param x Les abscisses.
+     * @param y Le tampon dans lequel ecrire les ordonnees.
+     * @param n Le nombre de valeurs.
+     */
+    void evaluate(const double* x, double* y, size_t n) const;
 };
 
 #endif // PIECEWISE_LINEAR_FUNCTION_H
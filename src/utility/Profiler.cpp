@@ -0,0 +1,92 @@
+#ifdef SIO_PROFILE
+
+#include <iomanip>
+
+#include "Profiler.h"
+
+std::atomic<uint64_t> Profiler::totalCycles[NUM_PHASES];
+std::atomic<uint64_t> Profiler::totalItems(0);
+std::atomic<uint64_t> Profiler::totalBatches(0);
+std::atomic<uint64_t> Profiler::resetTicks(0);
+std::atomic<int64_t> Profiler::resetNanoseconds(0);
+
+/**
+ * @return L'instant courant de l'horloge, en nanosecondes.
+ */
+static int64_t clockNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::commit(State& s) {
+    for (int p = 0; p < NUM_PHASES; ++p) {
+        totalCycles[p].fetch_add(s.cycles[p], std::memory_order_relaxed);
+        s.cycles[p] = 0;
+    }
+    totalItems.fetch_add(s.items, std::memory_order_relaxed);
+    totalBatches.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Profiler::reset() {
+    for (int p = 0; p < NUM_PHASES; ++p) {
+        totalCycles[p] = 0;
+    }
+    totalItems = 0;
+    totalBatches = 0;
+
+    resetTicks = ticks();
+    resetNanoseconds = clockNanoseconds();
+}
+
+Profiler::Breakdown Profiler::breakdown() {
+    Breakdown b = {};
+    b.batches = totalBatches.load();
+    b.items = totalItems.load();
+
+    // duree d'un cycle: comparaison du compteur et de l'horloge depuis reset
+    uint64_t elapsedTicks = ticks() - resetTicks.load();
+    int64_t elapsedNanoseconds = clockNanoseconds() - resetNanoseconds.load();
+    double nsPerTick = elapsedTicks > 0 ? (double)elapsedNanoseconds / elapsedTicks : 0;
+
+    for (int p = 0; p < NUM_PHASES; ++p) {
+        b.nsPerItem[p] = b.items > 0 ? totalCycles[p].load() * nsPerTick / b.items : 0;
+    }
+    return b;
+}
+
+void Profiler::print(std::ostream& os, const Breakdown& b) {
+    double total = 0;
+    for (int p = 0; p < NUM_PHASES; ++p) {
+        total += b.nsPerItem[p];
+    }
+
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+
+    os << std::fixed << std::setprecision(2) << "  profil [ns/element]:";
+    for (int p = 0; p < NUM_PHASES; ++p) {
+        if (b.nsPerItem[p] > 0) {
+            os << ' ' << phaseName((Phase)p) << ' ' << b.nsPerItem[p]
+               << " (" << std::setprecision(0) << 100 * b.nsPerItem[p] / total << "%)" << std::setprecision(2);
+        }
+    }
+    os << " | total " << total << " (" << b.batches << " lots chronometres)" << std::endl;
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+const char* Profiler::phaseName(Phase phase) {
+    switch (phase) {
+        case UNIFORM: return "uniformes";
+        case SELECT_PIECE: return "selection";
+        case TRANSFORM: return "transformation";
+        case FIND_PIECE: return "recherche";
+        case INTEGRAND: return "g(X)";
+        case ACCUMULATE: return "accumulation";
+        case NUM_PHASES: break;
+    }
+    return "";
+}
+
+#endif // SIO_PROFILE
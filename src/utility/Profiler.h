@@ -0,0 +1,177 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+/**
+ * Profilage des boucles d'echantillonnage par phase (tirage des uniformes, selection du morceau, ...), active a la
+ * compilation par SIO_PROFILE (option CMake SIO_PROFILING).
+ *
+ * Les boucles sont instrumentees avec deux macros:
+ * - SIO_PROFILE_BATCH(n): debut d'un lot de n elements. Un lot sur SAMPLING_PERIOD (par thread) est chronometre;
+ * - SIO_PROFILE_MARK(PHASE): fin d'une phase du lot: le temps ecoule depuis la marque precedente (ou le debut du lot)
+ *   est attribue a la phase.
+ *
+ * Un lot commence a l'interieur d'un lot deja ouvert (ex: generateur appele par une methode) est confondu avec lui:
+ * les marques des deux boucles se suivent sur la meme ligne de temps. Les temps sont lus avec le compteur de cycles
+ * du processeur (rdtsc) et convertis en nanosecondes a partir de l'horloge.
+ *
+ * Sans SIO_PROFILE, les macros ne produisent aucun code et la classe n'existe pas.
+ */
+#ifdef SIO_PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+class Profiler {
+public:
+    /**
+     * Phases d'une boucle d'echantillonnage.
+     */
+    enum Phase {
+        UNIFORM,       // tirage des uniformes (fillUniform)
+        SELECT_PIECE,  // selection du morceau k (generateK / selectPiece)
+        TRANSFORM,     // transformation des uniformes en realisations (inverse, symetrie, rejet, changement d'echelle)
+        FIND_PIECE,    // recherche du morceau contenant X et evaluation de f (PiecewiseLinearFunction::findPiece)
+        INTEGRAND,     // evaluation de g(X)
+        ACCUMULATE,    // calcul des valeurs et mise a jour des accumulateurs
+        NUM_PHASES
+    };
+
+    // un lot chronometre sur SAMPLING_PERIOD
+    static const unsigned SAMPLING_PERIOD = 16;
+
+    /**
+     * Repartition du temps mesure depuis reset.
+     */
+    struct Breakdown {
+        uint64_t batches;                 // nombre de lots chronometres
+        uint64_t items;                   // nombre d'elements de ces lots
+        double nsPerItem[NUM_PHASES];     // temps moyen par element de chaque phase, en nanosecondes
+    };
+
+    /**
+     * Lot en cours du thread (voir SIO_PROFILE_BATCH).
+     */
+    class Batch {
+    private:
+        bool owner; // si ce lot a ouvert la ligne de temps du thread (et doit la fermer)
+
+    public:
+        explicit Batch(size_t n) : owner(false) {
+            State& s = state();
+            if (s.depth++ > 0 || ++s.tick < SAMPLING_PERIOD) {
+                return;
+            }
+            s.tick = 0;
+            s.active = true;
+            s.items = n;
+            s.last = ticks();
+            owner = true;
+        }
+
+        ~Batch() {
+            State& s = state();
+            --s.depth;
+            if (owner) {
+                s.active = false;
+                commit(s);
+            }
+        }
+
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+    };
+
+    /**
+     * Termine une phase du lot en cours (sans effet si le lot n'est pas chronometre).
+     */
+    static void mark(Phase phase) {
+        State& s = state();
+        if (s.active) {
+            uint64_t now = ticks();
+            s.cycles[phase] += now - s.last;
+            s.last = now;
+        }
+    }
+
+    /**
+     * Remet les mesures a zero (les lots en cours dans d'autres threads peuvent encore etre comptes).
+     */
+    static void reset();
+
+    /**
+     * @return La repartition du temps mesure depuis le dernier appel a reset.
+     */
+    static Breakdown breakdown();
+
+    /**
+     * Ecrit la repartition sur une ligne: temps par element de chaque phase et part du total.
+     */
+    static void print(std::ostream& os, const Breakdown& b);
+
+    /**
+     * @return Le nom d'une phase.
+     */
+    static const char* phaseName(Phase phase);
+
+private:
+    /**
+     * Ligne de temps d'un thread.
+     */
+    struct State {
+        bool active = false;   // si le lot en cours est chronometre
+        unsigned depth = 0;    // nombre de lots ouverts (lots imbriques compris)
+        unsigned tick = 0;     // nombre de lots depuis le dernier lot chronometre
+        size_t items = 0;
+        uint64_t last = 0;
+        uint64_t cycles[NUM_PHASES] = {};
+    };
+
+    // totaux de tous les threads (mis a jour a la fin de chaque lot chronometre)
+    static std::atomic<uint64_t> totalCycles[NUM_PHASES];
+    static std::atomic<uint64_t> totalItems;
+    static std::atomic<uint64_t> totalBatches;
+
+    // instant du dernier reset, pour convertir les cycles en nanosecondes
+    static std::atomic<uint64_t> resetTicks;
+    static std::atomic<int64_t> resetNanoseconds;
+
+    static State& state() {
+        static thread_local State s;
+        return s;
+    }
+
+    static uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    /**
+     * Ajoute les cycles d'un lot termine aux totaux.
+     */
+    static void commit(State& s);
+};
+
+#define SIO_PROFILE_CONCAT_(a, b) a##b
+#define SIO_PROFILE_CONCAT(a, b) SIO_PROFILE_CONCAT_(a, b)
+#define SIO_PROFILE_BATCH(n) Profiler::Batch SIO_PROFILE_CONCAT(sioProfileBatch, __LINE__)(n)
+#define SIO_PROFILE_MARK(phase) Profiler::mark(Profiler::phase)
+
+#else
+
+#define SIO_PROFILE_BATCH(n) ((void)0)
+#define SIO_PROFILE_MARK(phase) ((void)0)
+
+#endif // SIO_PROFILE
+
+#endif // PROFILER_H
@@ -0,0 +1,139 @@
+#ifndef SAMPLING_STATE_H
+#define SAMPLING_STATE_H
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstdint>
+
+#include "Accumulator.h"
+#include "CovarianceAccumulator.h"
+
+/**
+ * Ecrit l'etat fusionnable d'un echantillonnage (accumulateurs, sommes) dans un tampon binaire, afin de l'envoyer a
+ * un autre processus (voir MonteCarloMethod::saveState). Les nombres sont ecrits sur 8 octets, dans l'ordre des
+ * octets de la machine: l'etat n'est relu que par des processus de la meme architecture. Les valeurs sont exactes.
+ */
+class StateWriter {
+private:
+    std::string bytes;
+
+public:
+    void writeUInt(uint64_t value) {
+        append(value);
+    }
+
+    void writeDouble(double value) {
+        append(value);
+    }
+
+    /**
+     * Ecrit le resume d'un accumulateur: nombre de valeurs, moyenne et somme des carres des ecarts.
+     */
+    void writeAccumulator(const Accumulator& acc) {
+        writeUInt(acc.count());
+        writeDouble(acc.mean());
+        writeDouble(acc.sumSquaredDeviations());
+    }
+
+    /**
+     * Ecrit le resume d'un accumulateur de vecteurs: dimension, nombre de vecteurs, moyennes et co-moments.
+     */
+    void writeCovariance(const CovarianceAccumulator& acc) {
+        size_t dim = acc.dimension();
+        writeUInt(dim);
+        writeUInt(acc.count());
+        for (size_t i = 0; i < dim; ++i) {
+            writeDouble(acc.mean(i));
+        }
+        for (size_t i = 0; i < dim; ++i) {
+            for (size_t j = 0; j < dim; ++j) {
+                writeDouble(acc.comoment(i, j));
+            }
+        }
+    }
+
+    /**
+     * @return Les octets ecrits.
+     */
+    const std::string& data() const {
+        return bytes;
+    }
+
+private:
+    template <typename T>
+    void append(const T& value) {
+        bytes.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+};
+
+/**
+ * Relit un etat ecrit par StateWriter, dans le meme ordre.
+ *
+ * Toutes les lectures levent std::runtime_error si l'etat est tronque.
+ */
+class StateReader {
+private:
+    const std::string& bytes;
+    size_t pos = 0;
+
+public:
+    /**
+     * @param bytes Les octets a relire (qui doivent rester valides pendant la lecture).
+     */
+    explicit StateReader(const std::string& bytes) : bytes(bytes) {}
+
+    uint64_t readUInt() {
+        return read<uint64_t>();
+    }
+
+    double readDouble() {
+        return read<double>();
+    }
+
+    Accumulator readAccumulator() {
+        uint64_t n = readUInt();
+        double mean = readDouble();
+        double m2 = readDouble();
+        return Accumulator(n, mean, m2);
+    }
+
+    CovarianceAccumulator readCovariance() {
+        uint64_t dim = readUInt();
+        uint64_t n = readUInt();
+        if (dim > (bytes.size() - pos) / sizeof(double)) {
+            throw std::runtime_error("Etat d'echantillonnage tronque.");
+        }
+
+        std::vector<double> mu(dim), m2(dim * dim);
+        for (double& v : mu) {
+            v = readDouble();
+        }
+        for (double& v : m2) {
+            v = readDouble();
+        }
+        return CovarianceAccumulator(n, std::move(mu), std::move(m2));
+    }
+
+    /**
+     * @return Si tout l'etat a ete lu.
+     */
+    bool atEnd() const {
+        return pos == bytes.size();
+    }
+
+private:
+    template <typename T>
+    T read() {
+        if (bytes.size() - pos < sizeof(T)) {
+            throw std::runtime_error("Etat d'echantillonnage tronque.");
+        }
+
+        T value;
+        bytes.copy(reinterpret_cast<char*>(&value), sizeof(T), pos);
+        pos += sizeof(T);
+        return value;
+    }
+};
+
+#endif // SAMPLING_STATE_H
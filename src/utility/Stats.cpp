@@ -1,5 +1,7 @@
 #include <sstream>
 #include <iomanip>
+#include <numeric>
+#include <stdexcept>
 
 #include "Stats.h"
 
@@ -39,7 +41,8 @@ double Stats::sampleStdDev(const std::vector<double>& values) {
 
 double Stats::expectedValue(const PiecewiseLinearFunction& f) {
     double res = 0;
-    for (const Piece& p : f.pieces) {
+    for (uint64_t k = 0; k < f.size(); ++k) {
+        Piece p = f.piece(k);
         double x0 = p.x0, x1 = p.x1;
         double y0 = p.y0, y1 = p.y1;
 
@@ -62,6 +65,66 @@ ConfidenceInterval Stats::confidenceInterval(const std::vector<double>& values,
     return ConfidenceInterval (m, haldWidth);
 };
 
+std::vector<double> Stats::solve(std::vector<double> A, std::vector<double> b) {
+    size_t n = b.size();
+    if (A.size() != n * n) {
+        throw std::invalid_argument("La matrice doit etre carree et de la taille du second membre.");
+    }
+
+    // seuil en-deca duquel un pivot est considere comme nul, relatif au plus grand element de la diagonale
+    double maxDiag = 0;
+    for (size_t i = 0; i < n; ++i) {
+        maxDiag = std::max(maxDiag, std::fabs(A[i * n + i]));
+    }
+    double eps = 1e-12 * maxDiag;
+
+    std::vector<bool> zero(n, false);
+
+    for (size_t col = 0; col < n; ++col) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < n; ++row) {
+            if (std::fabs(A[row * n + col]) > std::fabs(A[pivot * n + col])) {
+                pivot = row;
+            }
+        }
+
+        if (!(std::fabs(A[pivot * n + col]) > eps)) {
+            zero[col] = true;
+            continue;
+        }
+
+        if (pivot != col) {
+            for (size_t j = 0; j < n; ++j) {
+                std::swap(A[pivot * n + j], A[col * n + j]);
+            }
+            std::swap(b[pivot], b[col]);
+        }
+
+        for (size_t row = col + 1; row < n; ++row) {
+            double factor = A[row * n + col] / A[col * n + col];
+            for (size_t j = col; j < n; ++j) {
+                A[row * n + j] -= factor * A[col * n + j];
+            }
+            b[row] -= factor * b[col];
+        }
+    }
+
+    // substitution arriere
+    std::vector<double> x(n, 0);
+    for (size_t i = n; i-- > 0;) {
+        if (zero[i]) {
+            continue;
+        }
+
+        double sum = b[i];
+        for (size_t j = i + 1; j < n; ++j) {
+            sum -= A[i * n + j] * x[j];
+        }
+        x[i] = sum / A[i * n + i];
+    }
+    return x;
+}
+
 Points Stats::createPoints(size_t numPoints, const std::function<double(double)>& func, double a, double b) {
 
     if (numPoints < 2) {
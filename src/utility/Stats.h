@@ -7,6 +7,7 @@
 #include <algorithm>
 #include <iostream>
 #include <cstdint>
+#include <functional>
 #include "PiecewiseLinearFunction.h"
 
 /**
@@ -92,6 +93,16 @@ public:
      */
     static ConfidenceInterval confidenceInterval(const std::vector<double>& values, double quantile);
 
+    /**
+     * Resout un systeme lineaire A x = b (elimination de Gauss avec pivot partiel). Les inconnues dont le pivot est
+     * negligeable (ex: variables redondantes dans une matrice de covariance) valent 0.
+     *
+     * @param A La matrice carree, ligne par ligne (n * n valeurs).
+     * @param b Le second membre (n valeurs).
+     * @return La solution x.
+     */
+    static std::vector<double> solve(std::vector<double> A, std::vector<double> b);
+
     /**
      * Cree une fonction affine par morceau a partir d'une fonction et d'un nombre de points donnes.
      * Une subdivision reguliere est creee (les largeurs des sous-intervelles sont toutes égales).
@@ -0,0 +1,190 @@
+#include <stdexcept>
+#include <sstream>
+#include <fstream>
+#include <limits>
+#include <cstdio>
+#include <cmath>
+
+#include "Telemetry.h"
+
+static std::atomic<uint64_t> nextId(1);
+
+Telemetry::Telemetry(const std::string& name)
+        : id(nextId.fetch_add(1)), name(name), created(Clock::now()),
+          estimate(std::numeric_limits<double>::quiet_NaN()), halfWidth(std::numeric_limits<double>::quiet_NaN()) {}
+
+Telemetry::~Telemetry() {
+    stopReporting();
+}
+
+Telemetry::Slot& Telemetry::localSlot() {
+    // compteurs du thread, par instance: la derniere utilisee est en tete
+    static thread_local std::vector<std::pair<uint64_t, Slot*>> owned;
+
+    if (!owned.empty() && owned.front().first == id) {
+        return *owned.front().second;
+    }
+
+    for (size_t i = 1; i < owned.size(); ++i) {
+        if (owned[i].first == id) {
+            std::swap(owned[0], owned[i]);
+            return *owned.front().second;
+        }
+    }
+
+    Slot* slot;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        slots.emplace_back(new Slot());
+        slot = slots.back().get();
+    }
+    owned.insert(owned.begin(), std::make_pair(id, slot));
+    return *slot;
+}
+
+void Telemetry::addEvaluations(uint64_t n) {
+    Slot::add(localSlot().evaluations, n);
+}
+
+void Telemetry::addTrials(uint64_t trials, uint64_t accepted) {
+    Slot& slot = localSlot();
+    Slot::add(slot.trials, trials);
+    Slot::add(slot.accepted, accepted);
+}
+
+void Telemetry::publish(uint64_t samples, double time, double estimate, double halfWidth) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->samples = samples;
+    this->samplingTime = time;
+    this->estimate = estimate;
+    this->halfWidth = halfWidth;
+}
+
+Telemetry::Snapshot Telemetry::snapshot() const {
+    Snapshot s = {};
+    s.time = std::chrono::duration<double>(Clock::now() - created).count();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const std::unique_ptr<Slot>& slot : slots) {
+        s.evaluations += slot->evaluations.load(std::memory_order_relaxed);
+        s.trials += slot->trials.load(std::memory_order_relaxed);
+        s.accepted += slot->accepted.load(std::memory_order_relaxed);
+    }
+
+    s.samples = samples;
+    s.samplesPerSecond = samplingTime > 0 ? samples / samplingTime : 0;
+    s.estimate = estimate;
+    s.halfWidth = halfWidth;
+
+    double interval = s.time - lastTime;
+    s.evaluationsPerSecond = interval > 0 ? (s.evaluations - lastEvaluations) / interval : 0;
+    lastTime = s.time;
+    lastEvaluations = s.evaluations;
+    return s;
+}
+
+void Telemetry::startReporting(double period, const Callback& callback, const std::string& path) {
+    if (!(period > 0)) {
+        throw std::invalid_argument("La periode de l'export doit etre strictement positive.");
+    }
+
+    stopReporting();
+    stopping = false;
+
+    reporter = std::thread([this, period, callback, path] {
+        std::chrono::duration<double> wait(period);
+        bool last = false;
+
+        while (!last) {
+            {
+                std::unique_lock<std::mutex> lock(reportMutex);
+                last = reportStop.wait_for(lock, wait, [this] { return stopping; });
+            }
+
+            Snapshot s = snapshot();
+            if (callback) {
+                callback(s);
+            }
+
+            // les erreurs d'ecriture sont ignorees: le fichier sera reecrit a l'export suivant
+            if (!path.empty()) {
+                std::string tmp = path + ".tmp";
+                {
+                    std::ofstream ofs(tmp, std::ios_base::trunc);
+                    ofs << toPrometheus(s);
+                }
+                std::rename(tmp.c_str(), path.c_str());
+            }
+        }
+    });
+}
+
+void Telemetry::stopReporting() {
+    if (!reporter.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(reportMutex);
+        stopping = true;
+    }
+    reportStop.notify_one();
+    reporter.join();
+}
+
+/**
+ * Ecrit une valeur au format de Prometheus (NaN et infinis compris).
+ */
+static std::string formatValue(double v) {
+    if (std::isnan(v)) {
+        return "NaN";
+    }
+    if (std::isinf(v)) {
+        return v > 0 ? "+Inf" : "-Inf";
+    }
+
+    std::ostringstream oss;
+    oss.precision(std::numeric_limits<double>::max_digits10);
+    oss << v;
+    return oss.str();
+}
+
+std::string Telemetry::toPrometheus(const Snapshot& s) const {
+    std::string labels;
+    if (!name.empty()) {
+        std::string escaped;
+        for (char c : name) {
+            if (c == '\\' || c == '"') {
+                escaped += '\\';
+                escaped += c;
+            } else if (c == '\n') {
+                escaped += "\\n";
+            } else {
+                escaped += c;
+            }
+        }
+        labels = "{method=\"" + escaped + "\"}";
+    }
+
+    std::ostringstream oss;
+    auto metric = [&oss, &labels](const char* metricName, const char* type, const char* help,
+                                  const std::string& value) {
+        oss << "# HELP " << metricName << ' ' << help << '\n';
+        oss << "# TYPE " << metricName << ' ' << type << '\n';
+        oss << metricName << labels << ' ' << value << '\n';
+    };
+
+    metric("sio_mc_evaluations_total", "counter", "Evaluations de la fonction.", std::to_string(s.evaluations));
+    metric("sio_mc_evaluations_per_second", "gauge", "Debit d'evaluations depuis l'export precedent.",
+           formatValue(s.evaluationsPerSecond));
+    metric("sio_mc_samples", "gauge", "Taille de l'echantillon courant.", std::to_string(s.samples));
+    metric("sio_mc_samples_per_second", "gauge", "Debit de l'echantillonnage courant.",
+           formatValue(s.samplesPerSecond));
+    metric("sio_mc_estimate", "gauge", "Aire estimee courante.", formatValue(s.estimate));
+    metric("sio_mc_ci_half_width", "gauge", "Demi-largeur courante de l'IC a 95%.", formatValue(s.halfWidth));
+    metric("sio_mc_rejection_trials_total", "counter", "Points proposes par l'acceptation-rejet.",
+           std::to_string(s.trials));
+    metric("sio_mc_rejection_accepted_total", "counter", "Points acceptes par l'acceptation-rejet.",
+           std::to_string(s.accepted));
+    return oss.str();
+}
@@ -0,0 +1,155 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+
+/**
+ * Compteurs d'un echantillonnage en cours, consultables pendant l'execution (voir MonteCarloMethod::setTelemetry,
+ * HitOrMiss::setTelemetry et EnvelopeRejection::setTelemetry).
+ *
+ * Les compteurs mis a jour par les threads de calcul (evaluations, essais et acceptations) sont propres a chaque
+ * thread: chaque thread ecrit dans sa propre ligne de cache, sans instruction atomique de lecture-modification-
+ * ecriture, et les lectures font la somme des threads. Les methodes ne les mettent a jour qu'une fois par lot de
+ * valeurs: le surcout est negligeable. Les statistiques de l'echantillon (taille, aire estimee, demi-largeur de l'IC)
+ * sont publiees a la fin de chaque etape d'echantillonnage.
+ *
+ * Un thread peut exporter periodiquement les compteurs (voir startReporting): appel d'une fonction et/ou ecriture
+ * d'un fichier texte au format d'exposition de Prometheus.
+ */
+class Telemetry {
+public:
+    /**
+     * Etat des compteurs a un instant donne.
+     */
+    struct Snapshot {
+        double time;                  // temps ecoule (en secondes) depuis la creation des compteurs
+        uint64_t evaluations;         // nombre d'evaluations de la fonction (mis a jour en continu)
+        double evaluationsPerSecond;  // debit d'evaluations depuis le snapshot precedent
+        uint64_t samples;             // taille de l'echantillon courant (mise a jour a chaque etape)
+        double samplesPerSecond;      // debit de l'echantillonnage courant (taille / temps)
+        double estimate;              // aire estimee courante (NaN avant la premiere etape)
+        double halfWidth;             // demi-largeur courante de l'IC a 95% (NaN avant la premiere etape)
+        uint64_t trials;              // nombre de points proposes par les methodes d'acceptation-rejet
+        uint64_t accepted;            // nombre de points acceptes par les methodes d'acceptation-rejet
+    };
+
+    // fonction appelee periodiquement avec l'etat des compteurs (depuis le thread d'export, sans lever d'exception)
+    typedef std::function<void(const Snapshot&)> Callback;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    /**
+     * Compteurs d'un thread: un seul thread y ecrit (chargement et stockage relaches, sans verrou), les autres ne
+     * font que les lire. Le remplissage evite de partager une ligne de cache avec les compteurs d'un autre thread.
+     */
+    struct Slot {
+        char before[64];
+        std::atomic<uint64_t> evaluations;
+        std::atomic<uint64_t> trials;
+        std::atomic<uint64_t> accepted;
+        char after[64];
+
+        Slot() : evaluations(0), trials(0), accepted(0) {}
+
+        static void add(std::atomic<uint64_t>& counter, uint64_t n) {
+            counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+    };
+
+    const uint64_t id;           // identifiant unique (voir localSlot)
+    const std::string name;      // valeur de l'etiquette "method" de l'export Prometheus
+    const Clock::time_point created;
+
+    mutable std::mutex mutex;    // protege les compteurs des threads et les statistiques publiees
+    std::vector<std::unique_ptr<Slot>> slots;
+    uint64_t samples = 0;
+    double samplingTime = 0;
+    double estimate;
+    double halfWidth;
+
+    mutable double lastTime = 0;            // instant et nombre d'evaluations du snapshot precedent
+    mutable uint64_t lastEvaluations = 0;
+
+    std::mutex reportMutex;
+    std::condition_variable reportStop;
+    bool stopping = false;
+    std::thread reporter;
+
+public:
+    /**
+     * @param name Le nom des compteurs dans l'export Prometheus (ex: nom de la methode), vide pour aucun.
+     */
+    explicit Telemetry(const std::string& name = "");
+
+    /**
+     * Arrete l'export periodique.
+     */
+    ~Telemetry();
+
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+
+    /**
+     * Ajoute des evaluations de la fonction aux compteurs du thread appelant.
+     */
+    void addEvaluations(uint64_t n);
+
+    /**
+     * Ajoute des points proposes et acceptes par la methode d'acceptation-rejet aux compteurs du thread appelant.
+     */
+    void addTrials(uint64_t trials, uint64_t accepted);
+
+    /**
+     * Publie les statistiques de l'echantillon a la fin d'une etape.
+     *
+     * @param samples La taille de l'echantillon.
+     * @param time Le temps ecoule depuis le debut de l'echantillonnage.
+     * @param estimate L'aire estimee.
+     * @param halfWidth La demi-largeur de l'IC.
+     */
+    void publish(uint64_t samples, double time, double estimate, double halfWidth);
+
+    /**
+     * @return L'etat des compteurs. Le debit d'evaluations est mesure depuis l'appel precedent.
+     */
+    Snapshot snapshot() const;
+
+    /**
+     * Lance l'export periodique des compteurs (arrete l'export precedent, s'il y en a un). Le fichier est d'abord
+     * ecrit sous un nom temporaire puis renomme: un lecteur ne voit jamais de fichier incomplet.
+     *
+     * @param period La periode de l'export, en secondes.
+     * @param callback La fonction a appeler a chaque export (peut etre vide).
+     * @param path Le fichier au format d'exposition de Prometheus a ecrire a chaque export (vide pour aucun).
+     * @throw std::invalid_argument Si la periode n'est pas strictement positive.
+     */
+    void startReporting(double period, const Callback& callback, const std::string& path = "");
+
+    /**
+     * Arrete l'export periodique, apres un dernier export.
+     */
+    void stopReporting();
+
+    /**
+     * @return Les compteurs au format d'exposition de Prometheus (version 0.0.4).
+     */
+    std::string toPrometheus(const Snapshot& s) const;
+
+private:
+    /**
+     * @return Les compteurs du thread appelant (crees a son premier appel).
+     */
+    Slot& localSlot();
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,82 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned numThreads) : nextTask(0) {
+    for (unsigned i = 1; i < numThreads; ++i) {
+        workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+
+    for (std::thread& t : workers) {
+        t.join();
+    }
+}
+
+unsigned ThreadPool::size() const {
+    return (unsigned)workers.size() + 1;
+}
+
+void ThreadPool::parallelFor(uint64_t numTasks, const Task& task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        this->numTasks = numTasks;
+        nextTask = 0;
+        active = (unsigned)workers.size();
+        error = nullptr;
+        ++generation;
+    }
+    wakeUp.notify_all();
+
+    runTasks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return active == 0; });
+    this->task = nullptr;
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::work() {
+    uint64_t seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeUp.wait(lock, [this, seen] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+
+        runTasks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--active == 0) {
+            finished.notify_one();
+        }
+    }
+}
+
+void ThreadPool::runTasks() {
+    uint64_t i;
+    while ((i = nextTask.fetch_add(1)) < numTasks) {
+        try {
+            (*task)(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+}
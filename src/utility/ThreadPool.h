@@ -0,0 +1,77 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <cstdint>
+
+/**
+ * Ensemble de threads persistants permettant d'executer une boucle de taches independantes en parallele.
+ * Le thread appelant participe egalement a l'execution des taches.
+ */
+class ThreadPool {
+public:
+    // tache prenant son indice en parametre
+    typedef std::function<void(uint64_t)> Task;
+
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wakeUp;   // reveille les threads lorsqu'une boucle est lancee
+    std::condition_variable finished; // signale la fin de la participation de tous les threads
+
+    const Task* task = nullptr;       // tache de la boucle en cours
+    uint64_t numTasks = 0;            // nombre de taches de la boucle en cours
+    std::atomic<uint64_t> nextTask;   // indice de la prochaine tache a executer
+    unsigned active = 0;              // nombre de threads n'ayant pas encore termine la boucle en cours
+    uint64_t generation = 0;          // numero de la boucle en cours
+    bool stopping = false;
+
+    std::exception_ptr error;         // premiere exception levee par une tache
+
+public:
+    /**
+     * Cree les threads.
+     *
+     * @param numThreads Le nombre total de threads, y compris le thread appelant (au moins 1).
+     */
+    explicit ThreadPool(unsigned numThreads);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @return Le nombre total de threads, y compris le thread appelant.
+     */
+    unsigned size() const;
+
+    /**
+     * Execute les taches d'indices 0 a numTasks-1 en parallele et attend qu'elles soient toutes terminees.
+     * L'ordre d'execution des taches n'est pas defini. Si une tache leve une exception, elle est relancee ici.
+     *
+     * @param numTasks Le nombre de taches.
+     * @param task La tache a executer pour chaque indice.
+     */
+    void parallelFor(uint64_t numTasks, const Task& task);
+
+private:
+    /**
+     * Boucle principale des threads.
+     */
+    void work();
+
+    /**
+     * Execute des taches de la boucle en cours tant qu'il en reste.
+     */
+    void runTasks();
+};
+
+#endif // THREAD_POOL_H
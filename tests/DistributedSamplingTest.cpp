@@ -0,0 +1,86 @@
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "montecarlo/ImportanceSampling.h"
+#include "generators/RandomEngine.h"
+#include "utility/Stats.h"
+
+using namespace std;
+
+// nombre de processus de calcul et taille des iterations du mode adaptatif
+const unsigned NUM_PROCESSES = 2;
+const uint64_t ITERATION_SIZE = 20000;
+const double TOLERANCE = 1e-9;
+
+/**
+ * @return Vrai si a et b sont egaux a la tolerance relative pres.
+ */
+static bool close(double a, double b) {
+    return fabs(a - b) <= TOLERANCE * max(fabs(a), fabs(b));
+}
+
+/**
+ * Verifie que l'echantillonnage preferentiel adaptatif reparti entre des processus fils donne la combinaison, ponderee
+ * par l'inverse des variances, des echantillonnages effectues dans un seul processus avec les flux des processus.
+ *
+ * @param workerSize La taille de l'echantillon de chaque processus.
+ * @param used Le nombre de valeurs de chaque processus prises en compte dans l'estimation (voir setAdaptive).
+ * @return Vrai si les resultats correspondent.
+ */
+static bool checkMerge(const MonteCarloMethod::Func& g, const Points& points, uint64_t workerSize, uint64_t used) {
+    vector<uint32_t> key = {24, 512, 42};
+
+    ImportanceSampling distributed(g, points.xs, points.ys);
+    seed_seq seed(key.begin(), key.end());
+    distributed.setSeed(seed);
+    distributed.setAdaptive(ITERATION_SIZE);
+    distributed.setNumProcesses(NUM_PROCESSES);
+    MonteCarloMethod::Sampling merged = distributed.sampleWithSize(NUM_PROCESSES * workerSize);
+
+    // meme travail que chaque processus (premier echantillonnage: flux 0 a NUM_PROCESSES - 1)
+    double invVar = 0, weightedAreas = 0;
+    bool sizes = true;
+    for (unsigned w = 0; w < NUM_PROCESSES; ++w) {
+        vector<uint32_t> params = workerSeedParams(key, w);
+        seed_seq workerSeed(params.begin(), params.end());
+
+        ImportanceSampling single(g, points.xs, points.ys);
+        single.setSeed(workerSeed);
+        single.setAdaptive(ITERATION_SIZE);
+        MonteCarloMethod::Sampling sampling = single.sampleWithSize(workerSize);
+        sizes = sizes && sampling.N == used && sampling.numEvaluations == workerSize;
+
+        double var = sampling.stdDevEstimator * sampling.stdDevEstimator;
+        invVar += 1 / var;
+        weightedAreas += sampling.areaEstimator / var;
+    }
+    double area = weightedAreas / invVar;
+    double stdDev = sqrt(1 / invVar);
+
+    cout << workerSize << " valeurs par processus" << endl;
+    cout << "Reparti: " << merged.areaEstimator << " +- " << merged.stdDevEstimator << " (N = " << merged.N << ")"
+         << endl;
+    cout << "Attendu: " << area << " +- " << stdDev << " (N = " << NUM_PROCESSES * used << ")" << endl;
+
+    return sizes && merged.N == NUM_PROCESSES * used && merged.numEvaluations == NUM_PROCESSES * workerSize
+           && close(merged.areaEstimator, area) && close(merged.stdDevEstimator, stdDev);
+}
+
+int main() {
+    // pic etroit mal represente par la densite initiale: chaque processus l'affine et son facteur scale() change
+    MonteCarloMethod::Func g = [](double x) {
+        return 1 + 100 * exp(-(x - 3) * (x - 3));
+    };
+    Points points = Stats::createPoints(4, g, 0, 15);
+
+    // derniere iteration incomplete de chaque processus: ajoutee par le processus avant la fusion si elle contient au
+    // moins la moitie d'une iteration, ignoree (et non comptee dans N) sinon
+    if (!checkMerge(g, points, 110000, 110000) || !checkMerge(g, points, 105000, 100000)) {
+        cerr << "Le resultat reparti ne correspond pas a celui des processus." << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
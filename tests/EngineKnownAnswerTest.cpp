@@ -0,0 +1,139 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "generators/Engines.h"
+
+using namespace std;
+
+__extension__ typedef unsigned __int128 uint128;
+
+static int failures = 0;
+
+/**
+ * Compare une valeur produite a la valeur de reference.
+ */
+static void check(const string& name, size_t i, uint64_t value, uint64_t expected) {
+    if (value != expected) {
+        cerr << name << ": valeur " << i << " = " << hex << value << ", attendu " << expected << dec << endl;
+        ++failures;
+    }
+}
+
+/**
+ * Verifie qu'un remplissage par lots donne toUnit des valeurs attendues (voies et sauts compris).
+ */
+static void checkFill(const string& name, const double* values, const uint64_t* expected, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (values[i] != toUnit(expected[i])) {
+            cerr << name << " (lots): valeur " << i << " differente" << endl;
+            ++failures;
+        }
+    }
+}
+
+/**
+ * xoshiro256++: implementation de reference (Blackman et Vigna) initialisee avec l'etat {1, 2, 3, 4}.
+ */
+static void testXoshiro256PlusPlus() {
+    const uint64_t expected[10] = {
+            41943041ULL, 58720359ULL, 3588806011781223ULL, 3591011842654386ULL, 9228616714210784205ULL,
+            9973669472204895162ULL, 14011001112246962877ULL, 12406186145184390807ULL, 15849039046786891736ULL,
+            10450023813501588000ULL};
+    const uint64_t state[4] = {1, 2, 3, 4};
+
+    // toutes les voies dans l'etat de reference: la i-eme valeur de chaque voie est la i-eme valeur de reference
+    Xoshiro256PlusPlus engine;
+    for (size_t l = 0; l < Xoshiro256PlusPlus::LANES; ++l) {
+        engine.setLaneState(l, state);
+    }
+    for (size_t i = 0; i < 10 * Xoshiro256PlusPlus::LANES; ++i) {
+        check("xoshiro256++", i, engine(), expected[i / Xoshiro256PlusPlus::LANES]);
+    }
+
+    Xoshiro256PlusPlus batch;
+    uint64_t interleaved[10 * Xoshiro256PlusPlus::LANES];
+    for (size_t l = 0; l < Xoshiro256PlusPlus::LANES; ++l) {
+        batch.setLaneState(l, state);
+    }
+    for (size_t i = 0; i < 10 * Xoshiro256PlusPlus::LANES; ++i) {
+        interleaved[i] = expected[i / Xoshiro256PlusPlus::LANES];
+    }
+    double values[10 * Xoshiro256PlusPlus::LANES];
+    batch.fill(values, 10 * Xoshiro256PlusPlus::LANES);
+    checkFill("xoshiro256++", values, interleaved, 10 * Xoshiro256PlusPlus::LANES);
+}
+
+/**
+ * PCG64 (XSL RR 128/64): implementation de reference pcg64 (pcg-cpp) initialisee avec l'etat 42 et la suite 54.
+ */
+static void testPcg64() {
+    const uint64_t expected[6] = {
+            0x86b1da1d72062b68ULL, 0x1304aa46c9853d39ULL, 0xa3670e9e0dd50358ULL, 0xf9090e529a7dae00ULL,
+            0xc85b9fd837996f2cULL, 0x606121f8e3919196ULL};
+
+    Pcg64 engine;
+    engine.seed((uint128)42, (uint128)54);
+    for (size_t i = 0; i < 6; ++i) {
+        check("pcg64", i, engine(), expected[i]);
+    }
+
+    // les voies du remplissage par lots avancent de LANES pas a la fois (saut a^LANES, c(1 + a + ...))
+    Pcg64 batch;
+    batch.seed((uint128)42, (uint128)54);
+    double values[6];
+    batch.fill(values, 6);
+    checkFill("pcg64", values, expected, 6);
+}
+
+/**
+ * Philox4x64-10: vecteurs de test de Random123 (kat_vectors), un bloc par couple (compteur, cle).
+ */
+static void testPhilox4x64() {
+    struct Vector {
+        uint64_t counter[4], key[2], expected[4];
+    };
+    const uint64_t ones = ~0ULL;
+    const Vector vectors[] = {
+            {{0, 0, 0, 0}, {0, 0},
+             {0x16554d9eca36314cULL, 0xdb20fe9d672d0fdcULL, 0xd7e772cee186176bULL, 0x7e68b68aec7ba23bULL}},
+            {{ones, ones, ones, ones}, {ones, ones},
+             {0x87b092c3013fe90bULL, 0x438c3c67be8d0224ULL, 0x9cc7d7c69cd777b6ULL, 0xa09caebf594f0ba0ULL}},
+            {{0x243f6a8885a308d3ULL, 0x13198a2e03707344ULL, 0xa4093822299f31d0ULL, 0x082efa98ec4e6c89ULL},
+             {0x452821e638d01377ULL, 0xbe5466cf34e90c6cULL},
+             {0xa528f45403e61d95ULL, 0x38c72dbd566e9788ULL, 0xa5a1610e72fd18b5ULL, 0x57bd43b5e52b7fe6ULL}}};
+
+    for (const Vector& v : vectors) {
+        Philox4x64 engine;
+        engine.seed(v.key[0], v.key[1]);
+        engine.setCounter(v.counter);
+        for (size_t i = 0; i < 4; ++i) {
+            check("philox4x64", i, engine(), v.expected[i]);
+        }
+    }
+
+    // remplissage par lots: le premier bloc (compteur 0, cle 0) suivi des blocs suivants, chiffres LANES par LANES
+    Philox4x64 scalar, batch;
+    scalar.seed(0, 0);
+    batch.seed(0, 0);
+    const size_t n = 4 * Philox4x64::LANES + 3;
+    uint64_t expected[n];
+    for (size_t i = 0; i < n; ++i) {
+        expected[i] = scalar();
+    }
+    check("philox4x64", 0, expected[0], vectors[0].expected[0]);
+    double values[n];
+    batch.fill(values, n);
+    checkFill("philox4x64", values, expected, n);
+}
+
+/**
+ * Verifie les premieres valeurs des generateurs rapides (voir Engines.h) avec les valeurs publiees des
+ * implementations de reference, pour un etat, une graine ou une cle fixes.
+ */
+int main() {
+    testXoshiro256PlusPlus();
+    testPcg64();
+    testPhilox4x64();
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
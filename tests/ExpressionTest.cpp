@@ -0,0 +1,150 @@
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "utility/Expression.h"
+
+using namespace std;
+
+static int failures = 0;
+
+/**
+ * Compare deux valeurs: memes NaN et infinis, ecart relatif (ou absolu pres de 0) d'au plus 1e-12 sinon.
+ */
+static bool close(double value, double expected) {
+    if (std::isnan(expected) || std::isinf(expected)) {
+        return std::isnan(expected) ? std::isnan(value) : value == expected;
+    }
+    return std::fabs(value - expected) <= 1e-12 * std::max(1.0, std::fabs(expected));
+}
+
+/**
+ * Compare une expression a la fonction C++ equivalente sur n points de [lo, hi], en un point et par lots.
+ */
+static void checkValues(const string& source, const function<double(double)>& f, double lo, double hi,
+                        size_t n = 1000) {
+    Expression expression(source);
+    vector<double> x(n), y(n);
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = lo + (hi - lo) * i / (n - 1);
+    }
+    expression(x.data(), y.data(), n);
+
+    for (size_t i = 0; i < n; ++i) {
+        double expected = f(x[i]);
+        if (!close(expression(x[i]), expected) || !close(y[i], expected)) {
+            cerr << source << ": x = " << x[i] << ", attendu " << expected << ", obtenu " << expression(x[i])
+                 << " (un point) et " << y[i] << " (lot)" << endl;
+            ++failures;
+            return;
+        }
+    }
+}
+
+/**
+ * Verifie le code compile: nombre d'instructions et derniere instruction.
+ */
+static void checkCode(const string& source, size_t size, Expression::Op last) {
+    Expression expression(source);
+    const vector<Expression::Instruction>& code = expression.getCode();
+    if (code.size() != size || code.back().op != last) {
+        cerr << source << ": code compile inattendu (" << code.size() << " instructions)" << endl;
+        ++failures;
+    }
+}
+
+/**
+ * Verifie qu'une expression invalide est refusee avec la position de l'erreur.
+ */
+static void checkInvalid(const string& source, size_t position) {
+    try {
+        Expression expression(source);
+        cerr << "\"" << source << "\": expression acceptee" << endl;
+        ++failures;
+    } catch (const invalid_argument& e) {
+        string expected = "(position " + to_string(position) + ")";
+        if (string(e.what()).find(expected) == string::npos) {
+            cerr << "\"" << source << "\": " << e.what() << " (attendu " << expected << ")" << endl;
+            ++failures;
+        }
+    }
+}
+
+/**
+ * Verifie le parseur et l'interpreteur d'Expression: valeurs comparees aux fonctions C++ equivalentes (priorites,
+ * - unaire, puissances entieres et non entieres, fonctions, lots partiellement hors du domaine de FastMath), calcul
+ * des constantes a la compilation et positions des erreurs de syntaxe.
+ */
+int main() {
+    const double pi = acos(-1.0);
+
+    // priorites et associativite
+    checkValues("1 + 2*x - x/4", [](double x) { return 1 + 2 * x - x / 4; }, -10, 10);
+    checkValues("x - 3 - x", [](double x) { return x - 3 - x; }, -10, 10);
+    checkValues("(1 + x) * (2 - x) / (3 + x*x)", [](double x) { return (1 + x) * (2 - x) / (3 + x * x); }, -10, 10);
+    checkValues("8 / x / 2", [](double x) { return 8 / x / 2; }, 0.5, 10);
+    checkValues("2^x^2", [](double x) { return pow(2.0, x * x); }, -3, 3);
+
+    // - unaire
+    checkValues("-x^2", [](double x) { return -(x * x); }, -10, 10);
+    checkValues("--x", [](double x) { return x; }, -10, 10);
+    checkValues("2 * -x + +3", [](double x) { return 2 * -x + 3; }, -10, 10);
+    checkValues("x^-2", [](double x) { return 1 / (x * x); }, -10, 10, 1001);
+    checkValues("1 - -x", [](double x) { return 1 + x; }, -10, 10);
+
+    // puissances entieres (POW_I) et non entieres (pow)
+    checkValues("x^3", [](double x) { return x * x * x; }, -10, 10);
+    checkValues("x^0", [](double) { return 1.0; }, -10, 10);
+    checkValues("x^13", [](double x) { return pow(x, 13); }, -3, 3);
+    checkValues("x^-5", [](double x) { return pow(x, -5); }, 0.5, 4);
+    checkValues("x^64", [](double x) { return pow(x, 64); }, -1.5, 1.5);
+    checkValues("x^65", [](double x) { return pow(x, 65); }, -1.5, 1.5);
+    checkValues("x^0.5", [](double x) { return pow(x, 0.5); }, -4, 4);
+    checkValues("x^(1/3)", [](double x) { return pow(x, 1.0 / 3); }, 0, 8);
+    checkValues("2^x", [](double x) { return pow(2.0, x); }, -10, 10);
+    checkValues("pow(x, x)", [](double x) { return pow(x, x); }, 0.1, 5);
+
+    // fonctions et constantes
+    checkValues("exp(x) + log(x) + sqrt(x) + cos(x)", [](double x) { return exp(x) + log(x) + sqrt(x) + cos(x); },
+                0.01, 20);
+    checkValues("sin(x) * tan(x/3) - abs(x)", [](double x) { return sin(x) * tan(x / 3) - fabs(x); }, -4, 4);
+    checkValues("min(x, 1) + max(x, -1)", [](double x) { return min(x, 1.0) + max(x, -1.0); }, -5, 5);
+    checkValues("pi * e * x", [pi](double x) { return pi * exp(1.0) * x; }, -10, 10);
+    checkValues("(25 + x*(x-6)*(x-8)*(x-14)/25) * exp(sqrt(1 + cos(x^2/10)))",
+                [](double x) { return (25 + x * (x - 6) * (x - 8) * (x - 14) / 25) * exp(sqrt(1 + cos(x * x / 10))); },
+                0, 15);
+
+    // lots dont une partie est hors du domaine de FastMath: <cmath> pour tout le lot (NaN et infinis compris)
+    checkValues("log(x)", [](double x) { return log(x); }, -1, 10, 1001);
+    checkValues("sqrt(x)", [](double x) { return sqrt(x); }, -1, 10);
+    checkValues("exp(x)", [](double x) { return exp(x); }, 0, 800);
+    checkValues("cos(x)", [](double x) { return cos(x); }, 0, 4e6);
+    checkValues("log(x - 5) + sqrt(5 - x)", [](double x) { return log(x - 5) + sqrt(5 - x); }, 0, 10, 1001);
+
+    // calcul des constantes a la compilation
+    checkCode("2*pi + 3^2 - sqrt(16)", 1, Expression::Op::CONST);
+    checkCode("x * (2 + 3)", 2, Expression::Op::MUL_C);
+    checkCode("(1 - 3) / x", 2, Expression::Op::RDIV_C);
+    checkCode("x^3", 2, Expression::Op::POW_I);
+    checkCode("x^-2", 2, Expression::Op::POW_I);
+    checkCode("x^0.5", 3, Expression::Op::POW);
+    checkValues("2*pi + 3^2 - sqrt(16)", [pi](double) { return 2 * pi + 9 - 4; }, -1, 1, 10);
+
+    // erreurs de syntaxe
+    checkInvalid("", 1);
+    checkInvalid("x +", 4);
+    checkInvalid("x + * 2", 5);
+    checkInvalid("x 2", 3);
+    checkInvalid("(x + 1", 7);
+    checkInvalid("x $ 1", 3);
+    checkInvalid("foo(x)", 1);
+    checkInvalid("sqrt x", 6);
+    checkInvalid("pow(x)", 6);
+    checkInvalid("max(x, 1, 2)", 9);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,46 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "generators/RandomValueGenerator.h"
+#include "generators/RandomEngine.h"
+
+using namespace std;
+
+/**
+ * Verifie que generateBatch donne, pour chaque generateur, les memes valeurs et le meme etat du generateur aleatoire
+ * que des appels successifs a generate (tailles plus petites, egales et plus grandes qu'un lot).
+ */
+int main() {
+    vector<double> xs = {0, 2, 5, 9, 15}, ys = {1, 8, 0.5, 6, 2};
+    HitOrMiss hitOrMiss(xs, ys);
+    EnvelopeRejection envelope(xs, ys);
+    Geometric geometric(xs, ys);
+    InverseFunctions inverse(xs, ys);
+
+    const pair<string, const RandomValueGenerator*> generators[] = {
+            {"HitOrMiss", &hitOrMiss}, {"EnvelopeRejection", &envelope}, {"Geometric", &geometric},
+            {"InverseFunctions", &inverse}};
+    const size_t sizes[] = {1, 7, 255, 256, 300, 1000, 5000};
+
+    int failures = 0;
+    for (const auto& generator : generators) {
+        for (size_t n : sizes) {
+            RandomEngine batchEngine(42), scalarEngine(42);
+            vector<double> batch(n);
+            generator.second->generateBatch(batchEngine, batch.data(), n);
+
+            bool same = true;
+            for (size_t i = 0; i < n && same; ++i) {
+                same = batch[i] == generator.second->generate(scalarEngine);
+            }
+            if (!same || batchEngine() != scalarEngine()) {
+                cerr << generator.first << ": les flux different pour n = " << n << endl;
+                ++failures;
+            }
+        }
+    }
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}